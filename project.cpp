@@ -2,18 +2,41 @@
 #include <vector>
 #include <unordered_map>
 #include <deque>
+#include <list>
+#include <map>
 #include <ctime>
 #include <cstdlib>
+#include <cstdio>
 #include <algorithm>
 #include <iomanip>
 #include <chrono>
 #include <thread>
 #include <random>
+#include <memory>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <functional>
+#include <climits>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <cmath>
+#include <cassert>
+#include <atomic>
+#include <csignal>
+#include <dlfcn.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
 
 // Constants
 const int DEFAULT_DISK_SIZE = 32768;
 const int DEFAULT_TLB_SIZE = 64;
 const int DEFAULT_VM_SIZE = 65536;
+const int MISS_FILTER_MIN_BLOCKS = 4096;  // Smallest level given a Bloom-filter fast-miss path
 
 enum CacheLevel {
     L1,
@@ -26,646 +49,5888 @@ enum CacheLevel {
 enum ReplacementPolicy {
     FIFO,
     LRU,
-    RANDOM
+    RANDOM,
+    PLUGIN,
+    SHIP,
+    HAWKEYE
 };
 
-// Cache block structure
-struct CacheBlock {
-    int tag;
-    bool valid;
-    CacheBlock() : tag(-1), valid(false) {}
+enum AccessType {
+    LOAD,
+    STORE,
+    FETCH  // Instruction fetch
 };
 
+// One simulated memory reference, the core that issued it and the program
+// counter of the instruction (0 when unknown)
+struct MemoryAccess {
+    int address;
+    int core;
+    AccessType type;
+    int pc;
+};
+
+// Context of the access being simulated, for replacement policies that look
+// beyond the slot. Thread-local so concurrent simulations do not share it.
+struct AccessContext {
+    int pc;
+    int core;
+};
+
+inline AccessContext& accessContext() {
+    static thread_local AccessContext context = { 0, 0 };
+    return context;
+}
+
+// Synthetic workload. count and seed apply to the random patterns, skew to
+// the zipfian pattern only.
+struct WorkloadConfig {
+    int pattern;              // 1 sequential, 2 random, 3 loop, 5 zipfian
+    int startAddress;
+    int endAddress;
+    long long count;          // Accesses of the random patterns
+    double skew;              // Zipfian exponent, in (0, 1)
+    unsigned long long seed;  // 0 = from the clock
+};
+
+// Counter-based random numbers: value n of a stream is SplitMix64's n-th
+// output for the seed, computed directly from (seed, n). Any chunk of a
+// stream can be generated on its own, so generated workloads do not depend on
+// how many threads produce them.
+inline unsigned long long counterRandom(unsigned long long seed, unsigned long long counter) {
+    unsigned long long x = seed + (counter + 1) * 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// Uniform in [0, 1)
+inline double counterUniform(unsigned long long seed, unsigned long long counter) {
+    return static_cast<double>(counterRandom(seed, counter) >> 11) / (1ULL << 53);
+}
+
+// Seeds of the simulator's own random number generators (random
+// replacement, device jitter and the like). Each thread draws from its own
+// sequence: with base 0 every draw is the clock, as before; a replica sets a
+// base so that the hierarchy it builds is seeded the same on every run.
+struct SeedSequence {
+    unsigned long long base;
+    unsigned long long drawn;
+};
+
+inline SeedSequence& seedSequence() {
+    static thread_local SeedSequence seeds = { 0, 0 };
+    return seeds;
+}
+
+inline unsigned int nextSeed() {
+    SeedSequence& seeds = seedSequence();
+    if (seeds.base == 0) {
+        return static_cast<unsigned int>(std::time(nullptr));
+    }
+    return static_cast<unsigned int>(counterRandom(seeds.base, seeds.drawn++));
+}
+
+// Fills addresses[i] = address(i) in fixed-size chunks spread over all hardware threads
+template <class AddressOf>
+std::vector<int> parallelGenerate(size_t count, AddressOf address) {
+    const size_t CHUNK = 1 << 16;
+    std::vector<int> addresses(count);
+    size_t chunks = (count + CHUNK - 1) / CHUNK;
+    size_t threads = std::min<size_t>(chunks, std::max(1u, std::thread::hardware_concurrency()));
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&]() {
+            for (size_t chunk = next++; chunk < chunks; chunk = next++) {
+                size_t end = std::min(count, (chunk + 1) * CHUNK);
+                for (size_t i = chunk * CHUNK; i < end; ++i) {
+                    addresses[i] = address(i);
+                }
+            }
+        });
+    }
+    for (size_t t = 0; t < workers.size(); ++t) {
+        workers[t].join();
+    }
+    return addresses;
+}
+
 // Forward declarations
 std::vector<int> generateSequentialAccess(int startAddress, int endAddress, int step);
-std::vector<int> generateRandomAccess(int rangeStart, int rangeEnd, int count);
+std::vector<int> generateRandomAccess(int rangeStart, int rangeEnd, long long count, unsigned long long seed);
 std::vector<int> generateLoopAccess(int startAddress, int endAddress, int loopCount);
+std::vector<int> generateZipfianAccess(int rangeStart, int rangeEnd, long long count, double skew,
+    unsigned long long seed);
 
 // Function to generate memory addresses based on pattern choice
-std::vector<int> generateAddresses(int patternChoice, int startAddress, int endAddress) {
-    switch (patternChoice) {
+std::vector<int> generateAddresses(const WorkloadConfig& workload) {
+    unsigned long long seed = workload.seed != 0 ? workload.seed : static_cast<unsigned long long>(std::time(nullptr));
+    switch (workload.pattern) {
     case 1:
-        return generateSequentialAccess(startAddress, endAddress, 10);
+        return generateSequentialAccess(workload.startAddress, workload.endAddress, 10);
     case 2:
-        return generateRandomAccess(startAddress, endAddress, 20);
+        return generateRandomAccess(workload.startAddress, workload.endAddress, workload.count, seed);
     case 3:
-        return generateLoopAccess(startAddress, endAddress, 5);
+        return generateLoopAccess(workload.startAddress, workload.endAddress, 5);
+    case 5:
+        return generateZipfianAccess(workload.startAddress, workload.endAddress, workload.count, workload.skew, seed);
     default:
         std::cerr << "Invalid pattern choice. Using sequential access by default.\n";
-        return generateSequentialAccess(startAddress, endAddress, 10);
+        return generateSequentialAccess(workload.startAddress, workload.endAddress, 10);
     }
 }
 
 // Function to generate sequential memory access pattern
 std::vector<int> generateSequentialAccess(int startAddress, int endAddress, int step) {
-    std::vector<int> addresses;
-    for (int addr = startAddress; addr <= endAddress; addr += step) {
-        addresses.push_back(addr);
-    }
-    return addresses;
+    size_t count = endAddress < startAddress ? 0 : (static_cast<long long>(endAddress) - startAddress) / step + 1;
+    return parallelGenerate(count, [=](size_t i) { return static_cast<int>(startAddress + static_cast<long long>(i) * step); });
 }
 
 // Function to generate random memory access pattern
-std::vector<int> generateRandomAccess(int rangeStart, int rangeEnd, int count) {
-    std::vector<int> addresses;
-    std::srand(static_cast<unsigned int>(std::time(nullptr)));
-    for (int i = 0; i < count; ++i) {
-        int addr = rangeStart + std::rand() % (rangeEnd - rangeStart + 1);
-        addresses.push_back(addr);
-    }
-    return addresses;
+std::vector<int> generateRandomAccess(int rangeStart, int rangeEnd, long long count, unsigned long long seed) {
+    unsigned long long range = static_cast<unsigned long long>(static_cast<long long>(rangeEnd) - rangeStart + 1);
+    return parallelGenerate(static_cast<size_t>(std::max(0LL, count)),
+        [=](size_t i) { return static_cast<int>(rangeStart + static_cast<long long>(counterRandom(seed, i) % range)); });
 }
 
 // Function to generate loop memory access pattern
 std::vector<int> generateLoopAccess(int startAddress, int endAddress, int loopCount) {
-    std::vector<int> addresses;
-    for (int loop = 0; loop < loopCount; ++loop) {
-        for (int addr = startAddress; addr <= endAddress; ++addr) {
-            addresses.push_back(addr);
+    size_t span = endAddress < startAddress ? 0 : static_cast<size_t>(static_cast<long long>(endAddress) - startAddress + 1);
+    return parallelGenerate(span * loopCount, [=](size_t i) { return static_cast<int>(startAddress + static_cast<long long>(i % span)); });
+}
+
+// Function to generate zipfian memory access pattern
+//
+// Ranks follow Gray et al.'s closed-form zipfian generator (as in YCSB), with
+// zeta(n) summed exactly for the first terms and by Euler-Maclaurin beyond.
+// Ranks are spread over the range by a multiplicative permutation so that the
+// hottest addresses do not all share a few blocks.
+std::vector<int> generateZipfianAccess(int rangeStart, int rangeEnd, long long count, double skew,
+    unsigned long long seed) {
+    const long long EXACT_TERMS = 1000;
+    long long n = std::max(1LL, static_cast<long long>(rangeEnd) - rangeStart + 1);
+    double zetan = 0;
+    for (long long i = 1; i <= std::min(n, EXACT_TERMS); ++i) {
+        zetan += std::pow(static_cast<double>(i), -skew);
+    }
+    if (n > EXACT_TERMS) {
+        double m = static_cast<double>(EXACT_TERMS);
+        double last = static_cast<double>(n);
+        zetan += (std::pow(last, 1 - skew) - std::pow(m, 1 - skew)) / (1 - skew)
+            + (std::pow(last, -skew) - std::pow(m, -skew)) / 2;
+    }
+    double zeta2 = 1 + std::pow(2.0, -skew);
+    double alpha = 1 / (1 - skew);
+    double eta = (1 - std::pow(2.0 / n, 1 - skew)) / (1 - zeta2 / zetan);
+
+    unsigned long long multiplier = 2654435761ULL % static_cast<unsigned long long>(n);
+    for (;; ++multiplier) {
+        unsigned long long a = multiplier, b = static_cast<unsigned long long>(n);
+        while (b != 0) {
+            unsigned long long r = a % b;
+            a = b;
+            b = r;
+        }
+        if (a == 1) {
+            break;
         }
     }
-    return addresses;
+
+    return parallelGenerate(static_cast<size_t>(std::max(0LL, count)), [=](size_t i) {
+        double u = counterUniform(seed, i);
+        double uz = u * zetan;
+        long long rank = uz < 1 ? 0 : uz < zeta2 ? 1
+            : std::min(n - 1, static_cast<long long>(n * std::pow(eta * u - eta + 1, alpha)));
+        return static_cast<int>(rangeStart + static_cast<long long>(rank * multiplier % n));
+    });
 }
 
-// Cache class
-class Cache {
+// Parses traces in Valgrind lackey format: one "<op> <hex address>[,size]"
+// record per line, optionally followed by the issuing core and a hex PC. I is
+// an instruction fetch, L (or R) a load, S (or W) a store and M a load
+// followed by a store to the same address; other lines are skipped. Records
+// without a core are dealt to cores round-robin; cores outside the
+// configured count wrap onto it and are counted. Data records without a PC
+// take the address of the preceding instruction fetch, as lackey emits each
+// instruction before its data accesses. The simulator's keys are ints, so
+// 64-bit addresses and PCs are folded into the low 31 bits and counted.
+class TraceParser {
 private:
-    int size;
-    int blockSize;
-    int numBlocks;
-    ReplacementPolicy policy;
-    int accessTime;
-    std::vector<CacheBlock> blocks;
-    std::deque<int> fifoQueue;
-    std::unordered_map<int, int> lruMap;
-    std::vector<int> randomIndices;
+    static const unsigned long long ADDRESS_MASK = INT_MAX;
+
+    int numCores;
+    long long records;
+    int lastFetch;
+    long long foldedAddresses;
+    long long foreignCores;  // Records naming a core outside the configured count
 
-    int getIndex(int address) {
-        return (address / blockSize) % numBlocks;
+    int fold(const std::string& hex) {
+        unsigned long long value = std::strtoull(hex.c_str(), nullptr, 16);
+        if (value > ADDRESS_MASK) {
+            foldedAddresses++;
+        }
+        return static_cast<int>(value & ADDRESS_MASK);
     }
 
 public:
-    int getAccessTime() { return accessTime; }
-    Cache(int s = 0, int bs = 1, int at = 0, ReplacementPolicy rp = FIFO)
-        : size(s), blockSize(bs), accessTime(at), policy(rp), numBlocks(s / bs) {
+    explicit TraceParser(int cores)
+        : numCores(std::max(1, cores)), records(0), lastFetch(0), foldedAddresses(0), foreignCores(0) {}
 
-        blocks.resize(numBlocks);
-        if (policy == RANDOM) {
-            randomIndices.resize(numBlocks);
-            for (int i = 0; i < randomIndices.size(); ++i) {
-                randomIndices[i] = i;
-            }
-            std::srand(static_cast<unsigned int>(std::time(nullptr)));
+    // Reports addresses that did not fit in 31 bits and cores that were wrapped
+    void warn(const std::string& path) const {
+        if (foldedAddresses > 0) {
+            std::cerr << foldedAddresses << " addresses in " << path
+                << " exceed 31 bits and were folded into the low 31 bits\n";
         }
-    }
-
-    int access(int address) {
-        int index = getIndex(address);
-        int tag = address / blockSize;
-        if (blocks[index].valid && blocks[index].tag == tag) {
-            if (policy == LRU) {
-                lruMap[tag] = static_cast<int>(std::time(nullptr));
-            }
-            return accessTime;  // Cache hit, return actual access time
+        if (foreignCores > 0) {
+            std::cerr << foreignCores << " records in " << path << " name a core outside the " << numCores
+                << " configured; they were wrapped onto core % " << numCores << "\n";
         }
-        replace(index, tag);
-        return -1;  // Cache miss, return -1
     }
 
-private:
-    void replace(int index, int tag) {
-        switch (policy) {
-        case FIFO:
-            if (fifoQueue.size() == numBlocks) {
-                int oldIndex = fifoQueue.front();
-                fifoQueue.pop_front();
-                blocks[oldIndex].tag = tag;
-                blocks[oldIndex].valid = true;
-                fifoQueue.push_back(index);
-            }
-            else {
-                blocks[index].tag = tag;
-                blocks[index].valid = true;
-                fifoQueue.push_back(index);
-            }
-            break;
-        case LRU:
-            if (lruMap.size() == numBlocks) {
-                int lruTag = -1;
-                int oldestTime = std::time(nullptr);
-                for (auto it = lruMap.begin(); it != lruMap.end(); ++it) {
-                    if (it->second < oldestTime) {
-                        oldestTime = it->second;
-                        lruTag = it->first;
-                    }
-                }
-                lruMap.erase(lruTag);
-                for (int i = 0; i < numBlocks; ++i) {
-                    if (blocks[i].tag == lruTag) {
-                        blocks[i].tag = tag;
-                        blocks[i].valid = true;
-                        lruMap[tag] = static_cast<int>(std::time(nullptr));
-                        return;
-                    }
-                }
-            }
-            else {
-                blocks[index].tag = tag;
-                blocks[index].valid = true;
-                lruMap[tag] = static_cast<int>(std::time(nullptr));
-            }
-            break;
-        case RANDOM:
-            std::shuffle(randomIndices.begin(), randomIndices.end(), std::default_random_engine(std::time(nullptr)));
-            for (int i = 0; i < numBlocks; ++i) {
-                if (!blocks[randomIndices[i]].valid) {
-                    blocks[randomIndices[i]].tag = tag;
-                    blocks[randomIndices[i]].valid = true;
-                    return;
-                }
+    // Appends the accesses of one line, if it holds a record
+    void parse(const std::string& line, std::vector<MemoryAccess>& accesses) {
+        std::istringstream fields(line);
+        std::string op;
+        std::string location;
+        if (!(fields >> op >> location) || op.size() != 1) {
+            return;
+        }
+        char kind = op[0];
+        if (kind != 'I' && kind != 'L' && kind != 'R' && kind != 'S' && kind != 'W' && kind != 'M') {
+            return;
+        }
+        MemoryAccess access;
+        access.address = fold(location);
+        if (!(fields >> access.core)) {
+            access.core = static_cast<int>(records % numCores);
+        }
+        else if (access.core < 0 || access.core >= numCores) {
+            foreignCores++;
+            access.core %= numCores;
+            if (access.core < 0) {
+                access.core += numCores;
             }
-            int randomIndex = std::rand() % numBlocks;
-            blocks[randomIndex].tag = tag;
-            blocks[randomIndex].valid = true;
-            break;
+        }
+        std::string pc;
+        access.pc = (fields >> pc) ? fold(pc) : lastFetch;
+        records++;
+        access.type = kind == 'I' ? FETCH : (kind == 'S' || kind == 'W') ? STORE : LOAD;
+        if (access.type == FETCH) {
+            access.pc = access.address;
+            lastFetch = access.address;
+        }
+        accesses.push_back(access);
+        if (kind == 'M') {
+            access.type = STORE;
+            accesses.push_back(access);
         }
     }
 };
 
-// TLB class
-class TLB {
-private:
-    int size;
-    int numBlocks;
-    int accessTime;
-    ReplacementPolicy policy;
-    std::vector<CacheBlock> blocks;
-    std::deque<int> fifoQueue;
-    std::unordered_map<int, int> lruMap;
-    std::vector<int> randomIndices;
+const unsigned long long TraceParser::ADDRESS_MASK;
+
+// Loads a whole trace file
+std::vector<MemoryAccess> loadTrace(const std::string& path, int numCores) {
+    std::vector<MemoryAccess> accesses;
+    std::ifstream in(path.c_str());
+    if (!in) {
+        std::cerr << "Cannot open trace file " << path << "\n";
+        return accesses;
+    }
+    TraceParser parser(numCores);
+    std::string line;
+    while (std::getline(in, line)) {
+        parser.parse(line, accesses);
+    }
+    parser.warn(path);
+    return accesses;
+}
 
-    int getIndex(int page) {
-        return page % numBlocks;
+// Generates a pattern and deals its addresses to cores round-robin
+std::vector<MemoryAccess> generateAccesses(const WorkloadConfig& workload, int numCores) {
+    std::vector<int> addresses = generateAddresses(workload);
+    std::vector<MemoryAccess> accesses(addresses.size());
+    for (size_t i = 0; i < addresses.size(); ++i) {
+        accesses[i].address = addresses[i];
+        accesses[i].core = static_cast<int>(i % std::max(1, numCores));
+        accesses[i].type = LOAD;
+        accesses[i].pc = 0;
     }
+    return accesses;
+}
+
+// Replacement policies
+//
+// A policy tracks the slots of a set-associative store (slot = set * ways + way)
+// and is notified of every hit, fill and invalidation. Each hit and fill is
+// preceded by onAccess with the set and key, for policies that learn from the
+// access stream. When a miss lands in a full set the store asks the policy
+// for a victim slot. Stores are templated on
+// the policy, so these hooks are statically dispatched and inlined; adding a
+// policy means writing one class and one case in makeAssociativeStore().
+
+// Per-set doubly linked list threaded through slot indices, giving the
+// recency-based policies O(1) hooks and victim selection at any associativity
+class SlotList {
+private:
+    int ways;
+    std::vector<int> prev;
+    std::vector<int> next;
+    std::vector<int> head;
+    std::vector<int> tail;
 
 public:
-    TLB(int s = DEFAULT_TLB_SIZE, int at = 0, ReplacementPolicy rp = FIFO)
-        : size(s), accessTime(at), policy(rp), numBlocks(s) {
+    SlotList(int numSets, int w)
+        : ways(w), prev(numSets * w, -1), next(numSets * w, -1), head(numSets, -1), tail(numSets, -1) {}
 
-        blocks.resize(numBlocks);
-        if (policy == RANDOM) {
-            randomIndices.resize(numBlocks);
-            for (int i = 0; i < randomIndices.size(); ++i) {
-                randomIndices[i] = i;
-            }
-            std::srand(static_cast<unsigned int>(std::time(nullptr)));
+    int front(int set) const { return head[set]; }
+
+    void pushBack(int slot) {
+        int set = slot / ways;
+        prev[slot] = tail[set];
+        next[slot] = -1;
+        if (tail[set] != -1) {
+            next[tail[set]] = slot;
+        }
+        else {
+            head[set] = slot;
         }
+        tail[set] = slot;
     }
 
-    int access(int page) {
-        int index = getIndex(page);
-        if (blocks[index].valid && blocks[index].tag == page) {
-            if (policy == LRU) {
-                lruMap[page] = static_cast<int>(std::time(nullptr));
-            }
-            return accessTime;  // TLB hit, return actual access time
+    void remove(int slot) {
+        int set = slot / ways;
+        if (prev[slot] != -1) {
+            next[prev[slot]] = next[slot];
+        }
+        else {
+            head[set] = next[slot];
+        }
+        if (next[slot] != -1) {
+            prev[next[slot]] = prev[slot];
         }
-        replace(index, page);
-        return -1;  // TLB miss, return -1
+        else {
+            tail[set] = prev[slot];
+        }
+        prev[slot] = next[slot] = -1;
     }
 
-    int getAccessTime() { return accessTime; }
-    int getSize() { return size; }
-
-private:
-    void replace(int index, int page) {
-        switch (policy) {
-        case FIFO:
-            if (fifoQueue.size() == numBlocks) {
-                int oldIndex = fifoQueue.front();
-                fifoQueue.pop_front();
-                blocks[oldIndex].tag = page;
-                blocks[oldIndex].valid = true;
-                fifoQueue.push_back(index);
-            }
-            else {
-                blocks[index].tag = page;
-                blocks[index].valid = true;
-                fifoQueue.push_back(index);
-            }
-            break;
-        case LRU:
-            if (lruMap.size() == numBlocks) {
-                int lruPage = -1;
-                int oldestTime = std::time(nullptr);
-                for (auto it = lruMap.begin(); it != lruMap.end(); ++it) {
-                    if (it->second < oldestTime) {
-                        oldestTime = it->second;
-                        lruPage = it->first;
-                    }
-                }
-                lruMap.erase(lruPage);
-                for (int i = 0; i < numBlocks; ++i) {
-                    if (blocks[i].tag == lruPage) {
-                        blocks[i].tag = page;
-                        blocks[i].valid = true;
-                        lruMap[page] = static_cast<int>(std::time(nullptr));
-                        return;
-                    }
-                }
-            }
-            else {
-                blocks[index].tag = page;
-                blocks[index].valid = true;
-                lruMap[page] = static_cast<int>(std::time(nullptr));
-            }
-            break;
-        case RANDOM:
-            std::shuffle(randomIndices.begin(), randomIndices.end(), std::default_random_engine(std::time(nullptr)));
-            for (int i = 0; i < numBlocks; ++i) {
-                if (!blocks[randomIndices[i]].valid) {
-                    blocks[randomIndices[i]].tag = page;
-                    blocks[randomIndices[i]].valid = true;
-                    return;
-                }
-            }
-            int randomIndex = std::rand() % numBlocks;
-            blocks[randomIndex].tag = page;
-            blocks[randomIndex].valid = true;
-            break;
+    void moveToBack(int slot) {
+        if (tail[slot / ways] != slot) {
+            remove(slot);
+            pushBack(slot);
         }
     }
 };
 
-// Performance analyzer class
-class PerformanceAnalyzer {
+// First-in first-out: evict the block filled longest ago
+class FifoPolicy {
+private:
+    SlotList order;
+
+public:
+    FifoPolicy(int numSets, int ways) : order(numSets, ways) {}
+
+    void onAccess(int, long long) {}
+    void onHit(int) {}
+    int selectVictim(int set) { return order.front(set); }
+    void onFill(int slot) { order.pushBack(slot); }
+    void onInvalidate(int slot) { order.remove(slot); }
+};
+
+// Least recently used: evict the block touched longest ago
+class LruPolicy {
+private:
+    SlotList recency;
+
+public:
+    LruPolicy(int numSets, int ways) : recency(numSets, ways) {}
+
+    void onAccess(int, long long) {}
+    void onHit(int slot) { recency.moveToBack(slot); }
+    int selectVictim(int set) { return recency.front(set); }
+    void onFill(int slot) { recency.pushBack(slot); }
+    void onInvalidate(int slot) { recency.remove(slot); }
+};
+
+// Random: evict any block of the set
+class RandomPolicy {
+private:
+    int ways;
+    std::mt19937 rng;
+
+public:
+    RandomPolicy(int, int w) : ways(w), rng(nextSeed()) {}
+
+    void onAccess(int, long long) {}
+    void onHit(int) {}
+    int selectVictim(int set) { return set * ways + static_cast<int>(rng() % ways); }
+    void onFill(int) {}
+    void onInvalidate(int) {}
+};
+
+// Program-counter-aware policies
+//
+// Both keep re-reference prediction values (RRPV) per slot and evict from
+// the distant end, but choose the insertion RRPV from a table of saturating
+// counters indexed by a hash of the PC of the access being simulated.
+// Tables have fixed sizes, as in the published designs.
+const int SHIP_TABLE_ENTRIES = 16384;
+const int HAWKEYE_TABLE_ENTRIES = 8192;
+
+inline int pcSignature(int pc, int tableEntries) {
+    unsigned int h = static_cast<unsigned int>(pc) * 0x9E3779B1u;
+    return static_cast<int>((h ^ (h >> 15)) & static_cast<unsigned int>(tableEntries - 1));
+}
+
+// SHiP-PC: blocks whose signature rarely sees a hit are inserted at the
+// distant RRPV. A hit trains the signature up; evicting a block that was
+// never hit trains it down.
+class ShipPolicy {
 private:
-    int totalAccesses;
-    int hits;
-    int misses;
-    std::vector<int> cacheHits;
-    std::vector<int> cacheMisses;
+    static const unsigned char MAX_RRPV = 3;
+    static const unsigned char MAX_COUNTER = 7;
+
+    int ways;
+    std::vector<unsigned char> rrpv;
+    std::vector<int> signature;
+    std::vector<bool> reused;
+    std::vector<unsigned char> counters;
 
 public:
-    PerformanceAnalyzer(int numCaches) : totalAccesses(0), hits(0), misses(0) {
-        cacheHits.resize(numCaches, 0);
-        cacheMisses.resize(numCaches, 0);
+    ShipPolicy(int numSets, int w)
+        : ways(w), rrpv(numSets * w, MAX_RRPV), signature(numSets * w, 0), reused(numSets * w, false),
+          counters(SHIP_TABLE_ENTRIES, 1) {}
+
+    void onAccess(int, long long) {}
+
+    void onHit(int slot) {
+        rrpv[slot] = 0;
+        if (!reused[slot]) {
+            reused[slot] = true;
+            unsigned char& counter = counters[signature[slot]];
+            counter = std::min<unsigned char>(counter + 1, MAX_COUNTER);
+        }
     }
 
-    void logAccess(bool hit, int cacheLevel) {
-        totalAccesses++;
-        if (hit) {
-            hits++;
-            if (cacheLevel < cacheHits.size()) {
-                cacheHits[cacheLevel]++;
-                for (int i = (cacheLevel + 1); i < cacheHits.size(); i++)
-                    cacheHits[i]++;
+    int selectVictim(int set) {
+        int base = set * ways;
+        int victim = base;
+        for (int slot = base + 1; slot < base + ways; ++slot) {
+            if (rrpv[slot] > rrpv[victim]) {
+                victim = slot;
             }
         }
-        else {
-            misses++;
-            if (cacheLevel < cacheMisses.size()) {
-                cacheMisses[cacheLevel]++;
+        // Age the set as if the search had been repeated until a slot reached MAX_RRPV
+        unsigned char age = MAX_RRPV - rrpv[victim];
+        if (age > 0) {
+            for (int slot = base; slot < base + ways; ++slot) {
+                rrpv[slot] += age;
             }
         }
+        return victim;
     }
 
-    void report() {
-        std::cout << "\nPerformance Report:\n";
-        std::cout << "Total Accesses: " << totalAccesses << "\n";
-        std::cout << "Total Hits: " << hits << "\n";
-        std::cout << "Total Misses: " << misses << "\n";
-        std::cout << "Overall Hit Rate: " << std::fixed << std::setprecision(2)
-            << static_cast<double>(hits) / totalAccesses * 100 << "%\n";
-        std::cout << "Overall Miss Rate: " << std::fixed << std::setprecision(2)
-            << static_cast<double>(misses) / totalAccesses * 100 << "%\n";
+    void onFill(int slot) {
+        signature[slot] = pcSignature(accessContext().pc, SHIP_TABLE_ENTRIES);
+        reused[slot] = false;
+        rrpv[slot] = counters[signature[slot]] == 0 ? MAX_RRPV : MAX_RRPV - 1;
+    }
 
-        for (size_t i = 0; i < 3; ++i) {
-            std::cout << "L" << i + 1 << " Cache Hit Rate: " << std::fixed << std::setprecision(2)
-                << static_cast<double>(cacheHits[i]) / totalAccesses * 100 << "%\n";
-            double missrate = 1 - static_cast<double>(cacheHits[i]) / totalAccesses;
-            std::cout << "L" << i + 1 << " Cache Miss Rate: " << std::fixed << std::setprecision(2)
-                << missrate * 100 << "%\n";
+    void onInvalidate(int slot) {
+        if (!reused[slot] && counters[signature[slot]] > 0) {
+            counters[signature[slot]]--;
         }
+        reused[slot] = true;  // Train once per fill
     }
 };
 
-// Memory hierarchy class
-class MemoryHierarchy {
-private:
-    std::vector<Cache> caches;
-    TLB tlb;
-    Cache ram;
-    int diskAccessTime;
-    PerformanceAnalyzer analyzer;
+const unsigned char ShipPolicy::MAX_RRPV;
+const unsigned char ShipPolicy::MAX_COUNTER;
 
-public:
-    MemoryHierarchy(const std::vector<int>& cacheSizes, const std::vector<int>& blockSizes,
-        const std::vector<int>& accessTimes, const std::vector<ReplacementPolicy>& policies,
-        int ramSize, int ramBlockSize, int ramAt, ReplacementPolicy ramPolicy,
-        int diskSize, int diskAt, int tlbSize, int tlbAt, ReplacementPolicy tlbPolicy)
-        : ram(ramSize, ramBlockSize, ramAt, ramPolicy), diskAccessTime(diskAt), analyzer(cacheSizes.size() + 1) {
+// Hawkeye-style: OPTgen replays sampled sets under Belady's algorithm to
+// learn whether each PC's blocks would have hit, and the resulting
+// predictor marks insertions cache-friendly (RRPV 0, ageing others) or
+// cache-averse (evicted first).
+class HawkeyePolicy {
+private:
+    static const unsigned char MAX_RRPV = 7;
+    static const unsigned char MAX_COUNTER = 7;
+    static const int SAMPLED_SETS = 64;
 
-        // Initialize caches
-        for (size_t i = 0; i < cacheSizes.size(); ++i) {
-            caches.emplace_back(cacheSizes[i], blockSizes[i], accessTimes[i], policies[i]);
-        }
+    struct Usage {
+        long long time;
+        int signature;
+    };
 
-        // Initialize TLB
-        tlb = TLB(tlbSize, tlbAt, tlbPolicy);
-    }
+    // Occupancy vector of one sampled set over the last historyLength accesses
+    struct OptGen {
+        long long time;
+        std::vector<int> occupancy;
+        std::unordered_map<long long, Usage> lastUse;
+    };
 
-    void simulateAccess(int address) {
-        bool hit = false;
-        int totalTime = 0;
-        std::cout << "\n\nAddress: " << address << std::endl;
-        std::cout << "Getting Physical address...\n";
-        // Access TLB
-        int page = address / tlb.getSize();
-        int time = tlb.access(page);
-        if (time != -1) {  // TLB hit
-            totalTime += time;
-            std::cout << "TLB Hit (Access time: " << totalTime << "ms)\n";
-            analyzer.logAccess(true, 0);
-
-            // Access caches
-            for (size_t i = 0; i < caches.size(); ++i) {
-                time = caches[i].access(address);
-                if (time != -1) {  // If cache hit
-                    totalTime += time;
-                    std::cout << "Hit in L" << i + 1 << " Cache (Access time: " << totalTime << "ms)\n";
-                    hit = true;
-                    analyzer.logAccess(true, i + 1);
-                    return; // Stop further accesses
-                }
-                else {
-                    std::cout << "Miss in L" << i + 1 << " Cache\n";
-                    totalTime += caches[i].getAccessTime();
-                    analyzer.logAccess(false, i + 1);
-                }
-            }
+    int ways;
+    int sampleStride;
+    int historyLength;
+    std::vector<unsigned char> rrpv;
+    std::vector<int> signature;
+    std::vector<bool> valid;
+    std::vector<unsigned char> counters;
+    std::vector<OptGen> samples;
 
-            // If all caches miss, access RAM
-            time = ram.access(address);
-            if (time != -1) {
-                totalTime += time;
-                std::cout << "Hit in RAM (Access time: " << totalTime << "ms)\n";
-                analyzer.logAccess(true, caches.size());
-                return;
-            }
-            else {
-                std::cout << "Miss in RAM\n";
-                analyzer.logAccess(false, caches.size());
-                totalTime += ram.getAccessTime();
-            }
+    bool friendly(int sig) const { return counters[sig] >= (MAX_COUNTER + 1) / 2; }
 
-            // Access disk
-            totalTime += diskAccessTime;
-            std::cout << "Wait...\n";
-            std::cout.flush();
-            std::this_thread::sleep_for(std::chrono::milliseconds(diskAccessTime));
-            std::cout << "Accessing Disk (Total access time: " << totalTime << "ms)\n";
-            analyzer.logAccess(false, caches.size() + 1);
-
-            // Assume Disk hit for this example
-            std::cout << "Hit in Disk (Access time: " << totalTime << "ms)\n";
-            analyzer.logAccess(true, caches.size() + 1);
-        }
-        else { // TLB miss, proceed to main memory
-            totalTime += tlb.getAccessTime();
-            std::cout << "TLB Miss, Accessing RAM to get Physical Address (Access time: " << totalTime << "ms)\n";
-            analyzer.logAccess(false, 0);
-
-            // Access RAM directly to get physical address
-            time = ram.access(address);
-            if (time != -1) {
-                totalTime += time;
-                std::cout << "Hit in RAM (Access time: " << totalTime << "ms)\n";
-                analyzer.logAccess(true, caches.size());
-
-                // Access caches
-                for (size_t i = 0; i < caches.size(); ++i) {
-                    time = caches[i].access(address);
-                    if (time != -1) {  // If cache hit
-                        totalTime += time;
-                        std::cout << "Hit in L" << i + 1 << " Cache (Access time: " << totalTime << "ms)\n";
-                        hit = true;
-                        analyzer.logAccess(true, i + 1);
-                        return; // Stop further accesses
-                    }
-                    else {
-                        std::cout << "Miss in L" << i + 1 << " Cache\n";
-                        analyzer.logAccess(false, i + 1);
-                        totalTime += caches[i].getAccessTime();
-                    }
-                }
+    void train(int sig, bool hit) {
+        if (hit) {
+            counters[sig] = std::min<unsigned char>(counters[sig] + 1, MAX_COUNTER);
+        }
+        else if (counters[sig] > 0) {
+            counters[sig]--;
+        }
+    }
 
-                // If all caches miss, access RAM again
-                time = ram.access(address);
-                if (time != -1) {
-                    totalTime += time;
-                    std::cout << "Hit in RAM (Access time: " << totalTime << "ms)\n";
-                    analyzer.logAccess(true, caches.size());
-                    return;
-                }
-                else {
-                    std::cout << "Miss in RAM\n";
-                    analyzer.logAccess(false, caches.size());
-                    totalTime += ram.getAccessTime();
+    // Would OPT, with this set's capacity, have kept key since its last use?
+    void replay(OptGen& opt, long long key, int sig) {
+        long long now = opt.time++;
+        opt.occupancy[now % historyLength] = 0;
+        std::unordered_map<long long, Usage>::iterator it = opt.lastUse.find(key);
+        if (it != opt.lastUse.end()) {
+            long long last = it->second.time;
+            bool hit = now - last < historyLength;
+            for (long long t = last; hit && t < now; ++t) {
+                hit = opt.occupancy[t % historyLength] < ways;
+            }
+            if (hit) {
+                for (long long t = last; t < now; ++t) {
+                    opt.occupancy[t % historyLength]++;
                 }
-
-                // Access disk
-                totalTime += diskAccessTime;
-                std::cout << "Wait...\n";
-                std::cout.flush();
-                std::this_thread::sleep_for(std::chrono::milliseconds(diskAccessTime));
-                std::cout << "Accessing Disk (Total access time: " << totalTime << "ms)\n";
-                analyzer.logAccess(false, caches.size() + 1);
-
-                // Assume Disk hit for this example
-                std::cout << "Hit in Disk (Access time: " << totalTime << "ms)\n";
-                analyzer.logAccess(true, caches.size() + 1);
-                return;
-
             }
-            else {
-                std::cout << "Miss in RAM\n";
-                analyzer.logAccess(false, caches.size());
-                totalTime += ram.getAccessTime();
-                totalTime += diskAccessTime;
-                std::cout << "Wait...\n";
-                std::cout.flush();
-                std::this_thread::sleep_for(std::chrono::milliseconds(diskAccessTime));
-                std::cout << "Accessing Disk (Total access time: " << totalTime << "ms)\n";
-                analyzer.logAccess(false, caches.size() + 1);
-            }
-
-            // Access caches
-            for (size_t i = 0; i < caches.size(); ++i) {
-                time = caches[i].access(address);
-                if (time != -1) {  // If cache hit
-                    totalTime += time;
-                    std::cout << "Hit in L" << i + 1 << " Cache (Access time: " << totalTime << "ms)\n";
-                    hit = true;
-                    analyzer.logAccess(true, i + 1);
-                    return; // Stop further accesses
+            train(it->second.signature, hit);
+        }
+        Usage usage = { now, sig };
+        opt.lastUse[key] = usage;
+        if (static_cast<int>(opt.lastUse.size()) > 4 * historyLength) {
+            for (it = opt.lastUse.begin(); it != opt.lastUse.end();) {
+                if (now - it->second.time >= historyLength) {
+                    train(it->second.signature, false);
+                    it = opt.lastUse.erase(it);
                 }
                 else {
-                    std::cout << "Miss in L" << i + 1 << " Cache\n";
-                    analyzer.logAccess(false, i + 1);
-                    totalTime += caches[i].getAccessTime();
+                    ++it;
                 }
             }
+        }
+    }
 
-            // If all caches miss, access RAM again
-            time = ram.access(address);
-            if (time != -1) {
-                totalTime += time;
-                std::cout << "Hit in RAM (Access time: " << totalTime << "ms)\n";
-                analyzer.logAccess(true, caches.size());
-                return;
-            }
-            else {
-                std::cout << "Miss in RAM\n";
-                analyzer.logAccess(false, caches.size());
-                totalTime += ram.getAccessTime();
+    void insert(int slot, int sig) {
+        signature[slot] = sig;
+        if (!friendly(sig)) {
+            rrpv[slot] = MAX_RRPV;
+            return;
+        }
+        rrpv[slot] = 0;
+        int base = slot / ways * ways;
+        for (int other = base; other < base + ways; ++other) {
+            if (other != slot && valid[other] && rrpv[other] < MAX_RRPV - 1) {
+                rrpv[other]++;
             }
+        }
+    }
 
-            // Access disk
-            totalTime += diskAccessTime;
-            std::cout << "Wait...\n";
-            std::cout.flush();
-            std::this_thread::sleep_for(std::chrono::milliseconds(diskAccessTime));
-            std::cout << "Accessing Disk (Total access time: " << totalTime << "ms)\n";
-            analyzer.logAccess(false, caches.size() + 1);
+public:
+    HawkeyePolicy(int numSets, int w)
+        : ways(w), sampleStride(std::max(1, numSets / SAMPLED_SETS)), historyLength(8 * w),
+          rrpv(numSets * w, MAX_RRPV), signature(numSets * w, 0), valid(numSets * w, false),
+          counters(HAWKEYE_TABLE_ENTRIES, (MAX_COUNTER + 1) / 2),
+          samples((numSets + sampleStride - 1) / sampleStride) {
+        for (size_t i = 0; i < samples.size(); ++i) {
+            samples[i].time = 0;
+            samples[i].occupancy.assign(historyLength, 0);
+        }
+    }
 
-            // Assume Disk hit for this example
-            std::cout << "Hit in Disk (Access time: " << totalTime << "ms)\n";
-            analyzer.logAccess(true, caches.size() + 1);
+    void onAccess(int set, long long key) {
+        if (set % sampleStride == 0) {
+            replay(samples[set / sampleStride], key, pcSignature(accessContext().pc, HAWKEYE_TABLE_ENTRIES));
         }
     }
 
-    void runSimulation(int patternChoice, int startAddress, int endAddress) {
-        std::vector<int> addresses = generateAddresses(patternChoice, startAddress, endAddress);
+    void onHit(int slot) {
+        insert(slot, pcSignature(accessContext().pc, HAWKEYE_TABLE_ENTRIES));
+    }
 
-        for (int address : addresses) {
-            simulateAccess(address);
+    int selectVictim(int set) {
+        int base = set * ways;
+        int victim = base;
+        for (int slot = base; slot < base + ways; ++slot) {
+            // Averse blocks go first, including friendly insertions whose PC
+            // has since been retrained as averse
+            if (rrpv[slot] == MAX_RRPV || !friendly(signature[slot])) {
+                return slot;
+            }
+            if (rrpv[slot] > rrpv[victim]) {
+                victim = slot;
+            }
         }
+        // Evicting a block predicted friendly: its PC was too optimistic
+        train(signature[victim], false);
+        return victim;
+    }
 
-        analyzer.report();
+    void onFill(int slot) {
+        valid[slot] = true;
+        insert(slot, pcSignature(accessContext().pc, HAWKEYE_TABLE_ENTRIES));
+    }
+
+    void onInvalidate(int slot) {
+        valid[slot] = false;
     }
 };
 
+const unsigned char HawkeyePolicy::MAX_RRPV;
+const unsigned char HawkeyePolicy::MAX_COUNTER;
+const int HawkeyePolicy::SAMPLED_SETS;
 
-// Function to get cache and block sizes from user
-void getCacheConfiguration(std::vector<int>& cacheSizes, std::vector<int>& blockSizes, std::vector<int>& accessTimes, std::vector<ReplacementPolicy>& policies) {
-    int numLayers;
-    std::cout << "Enter the number of cache layers (1-3): ";
-    std::cin >> numLayers;
-    while (numLayers < 1 || numLayers > 3) {
-        std::cout << "Invalid input. Enter the number of cache layers (1-3): ";
-        std::cin >> numLayers;
-    }
+// Out-of-tree policy loaded from a shared object
+//
+// The object must export these C functions, mirroring the hooks above:
+//   void* mhs_policy_create(int numSets, int ways);
+//   void  mhs_policy_destroy(void* state);
+//   void  mhs_policy_on_hit(void* state, int slot);
+//   int   mhs_policy_select_victim(void* state, int set);
+//   void  mhs_policy_on_fill(void* state, int slot);
+//   void  mhs_policy_on_invalidate(void* state, int slot);
+// The tuner, phase sampling and replicas run hierarchies on several threads,
+// so calls on different states may overlap and must not share unguarded data.
+struct PolicyPlugin {
+    void* handle;
+    void* (*create)(int, int);
+    void (*destroy)(void*);
+    void (*onHit)(void*, int);
+    int (*selectVictim)(void*, int);
+    void (*onFill)(void*, int);
+    void (*onInvalidate)(void*, int);
+};
 
-    cacheSizes.resize(numLayers);
-    blockSizes.resize(numLayers);
-    accessTimes.resize(numLayers);
-    policies.resize(numLayers);
+// The plugin shared by every level using the PLUGIN policy (handle is null until loaded)
+PolicyPlugin& policyPlugin() {
+    static PolicyPlugin plugin = { nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr };
+    return plugin;
+}
 
-    for (int i = 0; i < numLayers; ++i) {
-        std::cout << "Enter L" << i + 1 << " cache size: ";
-        std::cin >> cacheSizes[i];
-        std::cout << "Enter L" << i + 1 << " block size: ";
-        std::cin >> blockSizes[i];
-        std::cout << "Enter L" << i + 1 << " access time (in ms): ";
-        std::cin >> accessTimes[i];
-
-        int policy;
-        std::cout << "Select L" << i + 1 << " replacement policy (0 - FIFO, 1 - LRU, 2 - Random): ";
-        std::cin >> policy;
-        while (policy < 0 || policy > 2) {
-            std::cout << "Invalid input. Select replacement policy (0 - FIFO, 1 - LRU, 2 - Random): ";
-            std::cin >> policy;
-        }
-        policies[i] = static_cast<ReplacementPolicy>(policy);
+bool loadPolicyPlugin(const std::string& path) {
+    PolicyPlugin& plugin = policyPlugin();
+    if (plugin.handle) {
+        dlclose(plugin.handle);
+        plugin.handle = nullptr;
     }
-}
 
-// Function to get RAM configuration from user
-void getRAMConfiguration(int& ramSize, int& ramBlockSize, int& ramAccessTime, int& ramPolicy) {
-    std::cout << "Enter RAM size: ";
-    std::cin >> ramSize;
-    std::cout << "Enter RAM block size: ";
-    std::cin >> ramBlockSize;
-    std::cout << "Enter RAM access time (in ms): ";
-    std::cin >> ramAccessTime;
-    std::cout << "Select RAM replacement policy (0 - FIFO, 1 - LRU, 2 - Random): ";
-    std::cin >> ramPolicy;
-    while (ramPolicy < 0 || ramPolicy > 2) {
-        std::cout << "Invalid input. Select RAM replacement policy (0 - FIFO, 1 - LRU, 2 - Random): ";
-        std::cin >> ramPolicy;
+    void* handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        std::cerr << "Could not load policy plugin: " << dlerror() << "\n";
+        return false;
+    }
+
+    plugin.create = reinterpret_cast<void* (*)(int, int)>(dlsym(handle, "mhs_policy_create"));
+    plugin.destroy = reinterpret_cast<void (*)(void*)>(dlsym(handle, "mhs_policy_destroy"));
+    plugin.onHit = reinterpret_cast<void (*)(void*, int)>(dlsym(handle, "mhs_policy_on_hit"));
+    plugin.selectVictim = reinterpret_cast<int (*)(void*, int)>(dlsym(handle, "mhs_policy_select_victim"));
+    plugin.onFill = reinterpret_cast<void (*)(void*, int)>(dlsym(handle, "mhs_policy_on_fill"));
+    plugin.onInvalidate = reinterpret_cast<void (*)(void*, int)>(dlsym(handle, "mhs_policy_on_invalidate"));
+    if (!plugin.create || !plugin.destroy || !plugin.onHit || !plugin.selectVictim
+        || !plugin.onFill || !plugin.onInvalidate) {
+        std::cerr << "Policy plugin " << path << " does not export the mhs_policy_* functions\n";
+        dlclose(handle);
+        return false;
     }
+    plugin.handle = handle;
+    return true;
 }
 
-// Main function
-int main() {
-    std::vector<int> cacheSizes;
-    std::vector<int> blockSizes;
-    std::vector<int> accessTimes;
-    std::vector<ReplacementPolicy> policies;
-    int ramSize, ramBlockSize, ramAccessTime;
-    int diskSize, diskAccessTime;
-    int tlbSize, tlbAccessTime, tlbPolicy;
-    int ramPolicy;
-    int patternChoice;
-    int startAddress, endAddress;
+class PluginPolicy {
+private:
+    const PolicyPlugin& plugin;
+    int ways;
+    void* state;
 
-    // Loop to allow user to configure cache multiple times
-    while (true) {
-        // Get cache configuration from user
-        getCacheConfiguration(cacheSizes, blockSizes, accessTimes, policies);
+    PluginPolicy(const PluginPolicy&);
+    PluginPolicy& operator=(const PluginPolicy&);
 
-        // Get RAM configuration from user
-        getRAMConfiguration(ramSize, ramBlockSize, ramAccessTime, ramPolicy);
+public:
+    PluginPolicy(int numSets, int w) : plugin(policyPlugin()), ways(w), state(plugin.create(numSets, w)) {}
+    ~PluginPolicy() { plugin.destroy(state); }
 
-        std::cout << "Enter Disk size: ";
-        std::cin >> diskSize;
-        std::cout << "Enter Disk access time (in ms): ";
-        std::cin >> diskAccessTime;
-
-        std::cout << "Enter TLB size (Note that TLB's block size is equal to cache level 1's block size): ";
-        std::cin >> tlbSize;
-        std::cout << "Enter TLB access time (in ms): ";
-        std::cin >> tlbAccessTime;
-        std::cout << "Select TLB replacement policy (0 - FIFO, 1 - LRU, 2 - Random): ";
-        std::cin >> tlbPolicy;
-
-        // Select memory access pattern
-        std::cout << "\nSelect memory access pattern:\n";
-        std::cout << "1. Sequential Access\n";
-        std::cout << "2. Random Access\n";
-        std::cout << "3. Loop Access\n";
-        std::cout << "Enter your choice (1-3): ";
-        std::cin >> patternChoice;
-
-        std::cout << "Enter start address: ";
-        std::cin >> startAddress;
-        std::cout << "Enter end address: ";
-        std::cin >> endAddress;
-
-        // Create MemoryHierarchy instance and run simulation
-        MemoryHierarchy mh(cacheSizes, blockSizes, accessTimes, policies,
-            ramSize, ramBlockSize, ramAccessTime, static_cast<ReplacementPolicy>(ramPolicy),
-            diskSize, diskAccessTime, tlbSize, tlbAccessTime, static_cast<ReplacementPolicy>(tlbPolicy));
-        mh.runSimulation(patternChoice, startAddress, endAddress);
+    void onAccess(int, long long) {}
+    void onHit(int slot) { plugin.onHit(state, slot); }
 
-        // Option to continue or exit
-        std::string choice;
-        std::cout << "\nDo you want to configure another cache? (yes/no): ";
-        std::cin >> choice;
-        if (choice != "yes" && choice != "Yes") {
-            break; // Exit the loop if user does not want to continue
+    // A slot outside the set would corrupt another set, so fall back to its first way
+    int selectVictim(int set) {
+        int slot = plugin.selectVictim(state, set);
+        if (slot < set * ways || slot >= set * ways + ways) {
+            static std::atomic<bool> warned(false);
+            if (!warned.exchange(true)) {
+                std::cerr << "Policy plugin chose slot " << slot << " outside set " << set
+                    << "; evicting the set's first way instead.\n";
+            }
+            return set * ways;
+        }
+        return slot;
+    }
+
+    void onFill(int slot) { plugin.onFill(state, slot); }
+    void onInvalidate(int slot) { plugin.onInvalidate(state, slot); }
+};
+
+// Store geometry
+//
+// RuntimeGeometry is sized at construction; StaticGeometry bakes the shape in
+// as compile-time constants so set indexing folds into a mask or multiply.
+struct RuntimeGeometry {
+    int numSets;
+    int ways;
+    RuntimeGeometry(int s, int w) : numSets(s), ways(w) {}
+    int sets() const { return numSets; }
+    int associativity() const { return ways; }
+};
+
+template <int Sets, int Ways>
+struct StaticGeometry {
+    StaticGeometry(int, int) {}
+    int sets() const { return Sets; }
+    int associativity() const { return Ways; }
+};
+
+// Associative store interface, used where the policy is chosen at runtime
+template <typename Key>
+class AssociativeStoreBase {
+public:
+    virtual ~AssociativeStoreBase() {}
+    // Looks up key and fills it on a miss. Returns true on a hit.
+    virtual bool access(Key key) = 0;
+    // Looks up key, updating replacement state on a hit but never filling
+    virtual bool touch(Key key) = 0;
+    // Inserts a key known to be absent. Returns the evicted key, or INVALID
+    // (-1 cast to Key) if a free slot was used.
+    virtual Key fill(Key key) = 0;
+    // Returns true if key is resident, without touching replacement state
+    virtual bool contains(Key key) const = 0;
+    // Drops key if resident. Returns true if it was.
+    virtual bool invalidate(Key key) = 0;
+};
+
+// Set-associative store of keys shared by Cache and TLB
+//
+// Tags are kept in one contiguous array (set-major, an invalid slot holds
+// INVALID), so probing a set touches a single run of memory. Policy receives
+// the hooks described above.
+template <typename Key, class Geometry, class Policy>
+class AssociativeStore final : public AssociativeStoreBase<Key> {
+private:
+    Geometry geometry;
+    std::vector<Key> tags;
+    Policy policy;
+
+    // Keys are non-negative block or page numbers; the unsigned modulo keeps
+    // even a stray negative key inside the tag array
+    int setOf(Key key) const {
+        assert(key >= 0);
+        return static_cast<int>(static_cast<unsigned long long>(key) % static_cast<unsigned int>(geometry.sets()));
+    }
+
+    int find(Key key) const {
+        int base = setOf(key) * geometry.associativity();
+        for (int slot = base; slot < base + geometry.associativity(); ++slot) {
+            if (tags[slot] == key) {
+                return slot;
+            }
+        }
+        return -1;
+    }
+
+public:
+    static const Key INVALID = static_cast<Key>(-1);
+
+    AssociativeStore(int numSets, int ways)
+        : geometry(numSets, ways), tags(geometry.sets() * geometry.associativity(), INVALID),
+          policy(geometry.sets(), geometry.associativity()) {}
+
+    bool access(Key key) {
+        if (touch(key)) {
+            return true;
+        }
+        fill(key);
+        return false;
+    }
+
+    bool touch(Key key) {
+        int slot = find(key);
+        if (slot == -1) {
+            return false;
+        }
+        policy.onAccess(setOf(key), key);
+        policy.onHit(slot);
+        return true;
+    }
+
+    Key fill(Key key) {
+        int set = setOf(key);
+        policy.onAccess(set, key);
+        int base = set * geometry.associativity();
+        int slot = -1;
+        for (int i = base; i < base + geometry.associativity(); ++i) {
+            if (tags[i] == INVALID) {
+                slot = i;
+                break;
+            }
+        }
+        if (slot == -1) {
+            slot = policy.selectVictim(set);
+            policy.onInvalidate(slot);
+        }
+        Key evicted = tags[slot];
+        tags[slot] = key;
+        policy.onFill(slot);
+        return evicted;
+    }
+
+    bool contains(Key key) const {
+        return find(key) != -1;
+    }
+
+    bool invalidate(Key key) {
+        int slot = find(key);
+        if (slot == -1) {
+            return false;
+        }
+        policy.onInvalidate(slot);
+        tags[slot] = INVALID;
+        return true;
+    }
+};
+
+template <typename Key, class Geometry, class Policy>
+const Key AssociativeStore<Key, Geometry, Policy>::INVALID;
+
+// Open-addressing hash index from key to slot (linear probing, power-of-two
+// capacity kept at most half full, backward-shift deletion so no tombstones)
+template <typename Key>
+class TagIndex {
+private:
+    static const Key EMPTY = static_cast<Key>(-1);
+    std::vector<Key> keys;
+    std::vector<int> slots;
+    size_t mask;
+
+    size_t home(Key key) const {
+        unsigned long long h = static_cast<unsigned long long>(key) * 0x9E3779B97F4A7C15ULL;
+        return static_cast<size_t>(h >> 32) & mask;
+    }
+
+public:
+    explicit TagIndex(int entries) {
+        size_t capacity = 16;
+        while (capacity < static_cast<size_t>(entries) * 2) {
+            capacity <<= 1;
+        }
+        keys.assign(capacity, EMPTY);
+        slots.assign(capacity, -1);
+        mask = capacity - 1;
+    }
+
+    int find(Key key) const {
+        for (size_t i = home(key);; i = (i + 1) & mask) {
+            if (keys[i] == key) {
+                return slots[i];
+            }
+            if (keys[i] == EMPTY) {
+                return -1;
+            }
+        }
+    }
+
+    void insert(Key key, int slot) {
+        size_t i = home(key);
+        while (keys[i] != EMPTY) {
+            i = (i + 1) & mask;
+        }
+        keys[i] = key;
+        slots[i] = slot;
+    }
+
+    void erase(Key key) {
+        size_t i = home(key);
+        while (keys[i] != key) {
+            if (keys[i] == EMPTY) {
+                return;
+            }
+            i = (i + 1) & mask;
+        }
+        // Shift later members of the probe run back into the hole
+        for (size_t j = (i + 1) & mask; keys[j] != EMPTY; j = (j + 1) & mask) {
+            size_t h = home(keys[j]);
+            if (((j - h) & mask) >= ((j - i) & mask)) {
+                keys[i] = keys[j];
+                slots[i] = slots[j];
+                i = j;
+            }
+        }
+        keys[i] = EMPTY;
+        slots[i] = -1;
+    }
+};
+
+template <typename Key>
+const Key TagIndex<Key>::EMPTY;
+
+// Fully-associative store: a single set of any size, where hits go through
+// the hash index and victims come from the policy's O(1) hooks, so both stay
+// constant-time for millions of entries
+template <typename Key, class Policy>
+class HashedAssociativeStore final : public AssociativeStoreBase<Key> {
+private:
+    std::vector<Key> tags;
+    std::vector<int> freeSlots;
+    TagIndex<Key> index;
+    Policy policy;
+
+public:
+    static const Key INVALID = static_cast<Key>(-1);
+
+    explicit HashedAssociativeStore(int entries)
+        : tags(entries, INVALID), index(entries), policy(1, entries) {
+        freeSlots.reserve(entries);
+        for (int slot = entries - 1; slot >= 0; --slot) {
+            freeSlots.push_back(slot);
+        }
+    }
+
+    bool access(Key key) {
+        if (touch(key)) {
+            return true;
+        }
+        fill(key);
+        return false;
+    }
+
+    bool touch(Key key) {
+        int slot = index.find(key);
+        if (slot == -1) {
+            return false;
+        }
+        policy.onAccess(0, key);
+        policy.onHit(slot);
+        return true;
+    }
+
+    Key fill(Key key) {
+        int slot;
+        Key evicted = INVALID;
+        policy.onAccess(0, key);
+        if (!freeSlots.empty()) {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else {
+            slot = policy.selectVictim(0);
+            policy.onInvalidate(slot);
+            evicted = tags[slot];
+            index.erase(evicted);
+        }
+        tags[slot] = key;
+        index.insert(key, slot);
+        policy.onFill(slot);
+        return evicted;
+    }
+
+    bool contains(Key key) const {
+        return index.find(key) != -1;
+    }
+
+    bool invalidate(Key key) {
+        int slot = index.find(key);
+        if (slot == -1) {
+            return false;
+        }
+        policy.onInvalidate(slot);
+        index.erase(key);
+        tags[slot] = INVALID;
+        freeSlots.push_back(slot);
+        return true;
+    }
+};
+
+template <typename Key, class Policy>
+const Key HashedAssociativeStore<Key, Policy>::INVALID;
+
+// SHiP and Hawkeye scan the set for a victim and Hawkeye replays 8 x ways of
+// history per reuse, which would undo the hash index on large single-set
+// stores; those use LRU instead
+const int PC_POLICY_MAX_WAYS = 256;
+
+ReplacementPolicy storePolicy(int numSets, int ways, ReplacementPolicy policy) {
+    if ((policy == SHIP || policy == HAWKEYE) && numSets == 1 && ways > PC_POLICY_MAX_WAYS) {
+        return LRU;
+    }
+    return policy;
+}
+
+// Single-set stores use the hash index; anything else scans its set
+template <typename Key, class Policy>
+std::unique_ptr<AssociativeStoreBase<Key> > makeStoreWithPolicy(int numSets, int ways) {
+    if (numSets == 1 && ways > 1) {
+        return std::unique_ptr<AssociativeStoreBase<Key> >(new HashedAssociativeStore<Key, Policy>(ways));
+    }
+    return std::unique_ptr<AssociativeStoreBase<Key> >(new AssociativeStore<Key, RuntimeGeometry, Policy>(numSets, ways));
+}
+
+template <typename Key>
+std::unique_ptr<AssociativeStoreBase<Key> > makeAssociativeStore(int numSets, int ways, ReplacementPolicy policy) {
+    if (storePolicy(numSets, ways, policy) != policy) {
+        std::cerr << "SHiP and Hawkeye support fully associative levels of up to " << PC_POLICY_MAX_WAYS
+            << " entries. Using LRU replacement.\n";
+        policy = storePolicy(numSets, ways, policy);
+    }
+    switch (policy) {
+    case LRU:
+        return makeStoreWithPolicy<Key, LruPolicy>(numSets, ways);
+    case RANDOM:
+        return makeStoreWithPolicy<Key, RandomPolicy>(numSets, ways);
+    case SHIP:
+        return makeStoreWithPolicy<Key, ShipPolicy>(numSets, ways);
+    case HAWKEYE:
+        return makeStoreWithPolicy<Key, HawkeyePolicy>(numSets, ways);
+    case PLUGIN:
+        if (policyPlugin().handle) {
+            return makeStoreWithPolicy<Key, PluginPolicy>(numSets, ways);
+        }
+        std::cerr << "No policy plugin loaded. Using FIFO replacement.\n";
+        return makeStoreWithPolicy<Key, FifoPolicy>(numSets, ways);
+    case FIFO:
+    default:
+        return makeStoreWithPolicy<Key, FifoPolicy>(numSets, ways);
+    }
+}
+
+// Counting Bloom filter with 4-bit saturating counters, blocked so that all
+// of a key's counters share one 64-byte line: a probe costs one host cache
+// line instead of a walk through the tag store. Saturated counters stick, so
+// removals never create false negatives.
+class CountingBloomFilter {
+private:
+    static const int HASHES = 3;
+    static const int COUNTERS_PER_BLOCK = 128;  // 64 bytes of 4-bit counters
+    std::vector<unsigned char> counters;
+    unsigned long long blockMask;
+
+    static unsigned long long mix(unsigned long long x) {
+        x ^= x >> 30;
+        x *= 0xBF58476D1CE4E5B9ULL;
+        x ^= x >> 27;
+        x *= 0x94D049BB133111EBULL;
+        x ^= x >> 31;
+        return x;
+    }
+
+    // Counter index of the i-th hash of a key
+    size_t position(unsigned long long h, int i) const {
+        size_t block = static_cast<size_t>((h >> 32) & blockMask);
+        return block * COUNTERS_PER_BLOCK + static_cast<size_t>((h >> (7 * i)) & (COUNTERS_PER_BLOCK - 1));
+    }
+
+    int get(size_t pos) const {
+        return (counters[pos >> 1] >> ((pos & 1) * 4)) & 0xF;
+    }
+
+    void set(size_t pos, int value) {
+        unsigned char& byte = counters[pos >> 1];
+        int shift = static_cast<int>(pos & 1) * 4;
+        byte = static_cast<unsigned char>((byte & ~(0xF << shift)) | (value << shift));
+    }
+
+public:
+    // Sized at roughly eight counters per entry (about 3% false positives when full)
+    explicit CountingBloomFilter(int entries) {
+        unsigned long long blocks = 1;
+        while (blocks * COUNTERS_PER_BLOCK < static_cast<unsigned long long>(entries) * 8) {
+            blocks <<= 1;
+        }
+        counters.assign(static_cast<size_t>(blocks * COUNTERS_PER_BLOCK / 2), 0);
+        blockMask = blocks - 1;
+    }
+
+    bool mayContain(long long key) const {
+        unsigned long long h = mix(static_cast<unsigned long long>(key));
+        for (int i = 0; i < HASHES; ++i) {
+            if (get(position(h, i)) == 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void add(long long key) {
+        unsigned long long h = mix(static_cast<unsigned long long>(key));
+        for (int i = 0; i < HASHES; ++i) {
+            size_t pos = position(h, i);
+            int count = get(pos);
+            if (count < 0xF) {
+                set(pos, count + 1);
+            }
+        }
+    }
+
+    void remove(long long key) {
+        unsigned long long h = mix(static_cast<unsigned long long>(key));
+        for (int i = 0; i < HASHES; ++i) {
+            size_t pos = position(h, i);
+            int count = get(pos);
+            if (count > 0 && count < 0xF) {
+                set(pos, count - 1);
+            }
+        }
+    }
+};
+
+// Store decorator answering definite misses from a counting Bloom filter,
+// which it keeps in step with every fill, eviction and invalidation
+template <typename Key>
+class MissFilteredStore final : public AssociativeStoreBase<Key> {
+private:
+    std::unique_ptr<AssociativeStoreBase<Key> > inner;
+    CountingBloomFilter filter;
+
+public:
+    static const Key INVALID = static_cast<Key>(-1);
+    long long lookups;
+    long long filteredMisses;
+    long long falsePositives;
+
+    MissFilteredStore(std::unique_ptr<AssociativeStoreBase<Key> > store, int entries)
+        : inner(std::move(store)), filter(entries), lookups(0), filteredMisses(0), falsePositives(0) {}
+
+    bool access(Key key) {
+        if (touch(key)) {
+            return true;
+        }
+        fill(key);
+        return false;
+    }
+
+    bool touch(Key key) {
+        ++lookups;
+        if (!filter.mayContain(key)) {
+            ++filteredMisses;
+            return false;
+        }
+        if (inner->touch(key)) {
+            return true;
+        }
+        ++falsePositives;
+        return false;
+    }
+
+    Key fill(Key key) {
+        Key evicted = inner->fill(key);
+        filter.add(key);
+        if (evicted != INVALID) {
+            filter.remove(evicted);
+        }
+        return evicted;
+    }
+
+    bool contains(Key key) const {
+        return filter.mayContain(key) && inner->contains(key);
+    }
+
+    bool invalidate(Key key) {
+        if (!inner->invalidate(key)) {
+            return false;
+        }
+        filter.remove(key);
+        return true;
+    }
+};
+
+template <typename Key>
+const Key MissFilteredStore<Key>::INVALID;
+
+// Named end-of-run statistics of one simulation. The names and their order
+// depend only on the configuration, so runs of one configuration line up.
+struct RunStatistics {
+    std::vector<std::string> names;
+    std::vector<double> values;
+
+    void add(const std::string& name, double value) {
+        names.push_back(name);
+        values.push_back(value);
+    }
+};
+
+// Way partitioning of a shared cache between tenants (tenant = core % tenants)
+//
+// STATIC_WAYS gives each tenant a fixed way mask, as Intel CAT does. With
+// UTILITY_BASED, each tenant has a utility monitor (shadow LRU tags on
+// sampled sets counting hits per stack position) and every epoch the ways
+// are reassigned with the lookahead algorithm of utility-based cache
+// partitioning, as contiguous masks. Lookups hit in any way; a tenant only
+// fills, and so only evicts, within its mask.
+enum PartitionMode {
+    STATIC_WAYS,
+    UTILITY_BASED
+};
+
+struct PartitionConfig {
+    int level;  // Cache level partitioned (1 = L1), 0 = none
+    PartitionMode mode;
+    int tenants;
+    std::vector<unsigned long long> masks;  // STATIC_WAYS: way mask per tenant
+    int epochLength;                        // UTILITY_BASED: level accesses between repartitions
+};
+
+class PartitionedStore final : public AssociativeStoreBase<int> {
+private:
+    static const int MONITOR_SETS = 32;
+
+    int numSets;
+    int ways;
+    ReplacementPolicy policy;  // FIFO, LRU or RANDOM; others are treated as LRU
+    PartitionConfig config;
+    std::vector<int> tags;
+    std::vector<unsigned long long> stamps;  // Last use (LRU) or fill (FIFO)
+    unsigned long long clock;
+    std::mt19937 rng;
+    int monitorStride;
+    std::vector<std::vector<std::vector<int> > > shadow;  // [tenant][sampled set] LRU stack, MRU first
+    std::vector<std::vector<long long> > utility;         // [tenant][stack position] hits
+    long long epochAccesses;
+
+    int tenant() const {
+        int tenant = accessContext().core % config.tenants;
+        return tenant < 0 ? tenant + config.tenants : tenant;
+    }
+
+    int find(int key) const {
+        int base = (key % numSets) * ways;
+        for (int slot = base; slot < base + ways; ++slot) {
+            if (tags[slot] == key) {
+                return slot;
+            }
+        }
+        return -1;
+    }
+
+    // Feeds the tenant's utility monitor and repartitions at epoch ends
+    void monitor(int key) {
+        if (config.mode != UTILITY_BASED) {
+            return;
+        }
+        int set = key % numSets;
+        int t = tenant();
+        if (set % monitorStride == 0) {
+            std::vector<int>& stack = shadow[t][set / monitorStride];
+            std::vector<int>::iterator it = std::find(stack.begin(), stack.end(), key);
+            if (it != stack.end()) {
+                utility[t][it - stack.begin()]++;
+                stack.erase(it);
+            }
+            else if (static_cast<int>(stack.size()) >= ways) {
+                stack.pop_back();
+            }
+            stack.insert(stack.begin(), key);
+        }
+        if (++epochAccesses >= config.epochLength) {
+            repartition();
+            epochAccesses = 0;
+        }
+    }
+
+    // Lookahead allocation: repeatedly give the tenant with the highest
+    // marginal utility per way the ways that achieve it. Ties go round-robin,
+    // starting after the last tenant served; with no utility recorded at all
+    // (before the monitors have data, or after a quiet epoch) the ways are
+    // split equally.
+    void repartition() {
+        std::vector<int> allocation(config.tenants, 1);
+        int balance = ways - config.tenants;
+        long long total = 0;
+        for (int t = 0; t < config.tenants; ++t) {
+            for (size_t p = 0; p < utility[t].size(); ++p) {
+                total += utility[t][p];
+            }
+        }
+        if (total == 0) {
+            for (int t = 0; t < config.tenants; ++t) {
+                allocation[t] += balance / config.tenants + (t < balance % config.tenants ? 1 : 0);
+            }
+            balance = 0;
+        }
+        int start = 0;
+        while (balance > 0) {
+            int best = -1;
+            int bestWays = 1;
+            double bestUtility = -1;
+            for (int i = 0; i < config.tenants; ++i) {
+                int t = (start + i) % config.tenants;
+                long long gained = 0;
+                for (int k = 1; k <= balance && allocation[t] + k <= ways; ++k) {
+                    gained += utility[t][allocation[t] + k - 1];
+                    double perWay = static_cast<double>(gained) / k;
+                    if (perWay > bestUtility) {
+                        best = t;
+                        bestWays = k;
+                        bestUtility = perWay;
+                    }
+                }
+            }
+            if (best == -1) {
+                break;
+            }
+            allocation[best] += bestWays;
+            balance -= bestWays;
+            start = (best + 1) % config.tenants;
+        }
+        int first = 0;
+        for (int t = 0; t < config.tenants; ++t) {
+            config.masks[t] = ((allocation[t] >= 64 ? ~0ULL : (1ULL << allocation[t]) - 1)) << first;
+            first += allocation[t];
+            for (size_t p = 0; p < utility[t].size(); ++p) {
+                utility[t][p] /= 2;
+            }
+        }
+        repartitions++;
+    }
+
+public:
+    static const int INVALID = -1;
+    std::vector<long long> hits;
+    std::vector<long long> misses;
+    long long repartitions;
+
+    PartitionedStore(int sets, int w, ReplacementPolicy rp, const PartitionConfig& partition)
+        : numSets(sets), ways(w), policy(rp), config(partition), tags(sets * w, INVALID), stamps(sets * w, 0),
+          clock(0), rng(nextSeed()),
+          monitorStride(std::max(1, sets / MONITOR_SETS)), epochAccesses(0), repartitions(0) {
+        config.tenants = std::max(1, config.tenants);
+        if (config.mode == UTILITY_BASED) {
+            config.tenants = std::min(config.tenants, ways);  // At least one way each
+        }
+        config.epochLength = std::max(1, config.epochLength);
+        config.masks.resize(config.tenants, ~0ULL);
+        hits.assign(config.tenants, 0);
+        misses.assign(config.tenants, 0);
+        if (config.mode == UTILITY_BASED) {
+            shadow.assign(config.tenants, std::vector<std::vector<int> >((sets + monitorStride - 1) / monitorStride));
+            utility.assign(config.tenants, std::vector<long long>(ways, 0));
+            repartition();  // No utility yet, so equal shares
+            repartitions = 0;
+        }
+    }
+
+    bool access(int key) {
+        if (touch(key)) {
+            return true;
+        }
+        fill(key);
+        return false;
+    }
+
+    bool touch(int key) {
+        int slot = find(key);
+        if (slot == -1) {
+            return false;
+        }
+        hits[tenant()]++;
+        monitor(key);
+        if (policy != FIFO) {
+            stamps[slot] = ++clock;
+        }
+        return true;
+    }
+
+    int fill(int key) {
+        int t = tenant();
+        misses[t]++;
+        monitor(key);
+        unsigned long long mask = config.masks[t];
+        int base = (key % numSets) * ways;
+        int victim = -1;
+        int allowed = 0;
+        for (int way = 0; way < ways; ++way) {
+            if (way < 64 && !(mask >> way & 1ULL)) {
+                continue;
+            }
+            int slot = base + way;
+            allowed++;
+            if (tags[slot] == INVALID) {
+                victim = slot;
+                break;
+            }
+            if (policy == RANDOM ? rng() % allowed == 0 : (victim == -1 || stamps[slot] < stamps[victim])) {
+                victim = slot;
+            }
+        }
+        if (victim == -1) {  // Empty mask: fall back to the whole set
+            victim = base;
+            for (int slot = base; slot < base + ways; ++slot) {
+                if (tags[slot] == INVALID || stamps[slot] < stamps[victim]) {
+                    victim = slot;
+                }
+            }
+        }
+        int evicted = tags[victim];
+        tags[victim] = key;
+        stamps[victim] = ++clock;
+        return evicted;
+    }
+
+    bool contains(int key) const {
+        return find(key) != -1;
+    }
+
+    bool invalidate(int key) {
+        int slot = find(key);
+        if (slot == -1) {
+            return false;
+        }
+        tags[slot] = INVALID;
+        return true;
+    }
+
+    void report(const std::string& name) const {
+        for (int t = 0; t < config.tenants; ++t) {
+            long long lookups = hits[t] + misses[t];
+            std::cout << name << " Tenant " << t << " Hit Rate: " << std::fixed << std::setprecision(2)
+                << (lookups > 0 ? static_cast<double>(hits[t]) / lookups * 100 : 0.0) << "% (" << hits[t]
+                << " hits, " << misses[t] << " misses), Way Mask: 0x" << std::hex << config.masks[t] << std::dec << "\n";
+        }
+        if (config.mode == UTILITY_BASED) {
+            std::cout << name << " Repartitions: " << repartitions << "\n";
+        }
+    }
+
+    void statistics(const std::string& name, RunStatistics& out) const {
+        for (int t = 0; t < config.tenants; ++t) {
+            long long lookups = hits[t] + misses[t];
+            out.add(name + " Tenant " + std::to_string(t) + " Hit Rate (%)",
+                lookups > 0 ? static_cast<double>(hits[t]) / lookups * 100 : 0.0);
+        }
+        if (config.mode == UTILITY_BASED) {
+            out.add(name + " Repartitions", static_cast<double>(repartitions));
+        }
+    }
+};
+
+const int PartitionedStore::MONITOR_SETS;
+const int PartitionedStore::INVALID;
+
+// Sampling dead-block predictor (after Khan, Tian and Jimenez)
+//
+// A few sets of the level are mirrored in LRU sampler sets that ignore
+// bypassing; fully-associative levels sample keys instead of sets. Each
+// sampler entry remembers the PC signature that last touched it: a hit shows
+// that signature's blocks stay live, an eviction that they died. A fill is
+// predicted dead once its signature's 2-bit counter saturates.
+//
+// A bypassed key touched again within one level's worth of accesses counts
+// as a wrong prediction; one that is not counts as correct.
+class DeadBlockPredictor {
+private:
+    static const int TABLE_ENTRIES = 4096;
+    static const int SAMPLER_SETS = 32;
+    static const int SAMPLER_WAYS = 64;  // Per sampler set of a fully-associative level
+    static const unsigned char DEAD = 3;
+
+    struct Entry {
+        long long key;
+        int signature;
+    };
+
+    int stride;    // Every stride-th set is sampled
+    int keyRate;   // One in keyRate keys is sampled (fully-associative levels)
+    int samplerWays;
+    std::vector<std::vector<Entry> > sampler;  // Per sampler set, LRU first
+    std::vector<unsigned char> counters;
+    long long window;
+    long long accesses;
+    std::unordered_map<long long, long long> pending;     // Bypassed key -> access count at bypass
+    std::deque<std::pair<long long, long long> > expiry;  // (access count, key), oldest first
+
+public:
+    long long bypasses;
+    long long correct;
+    long long wrong;
+
+    DeadBlockPredictor(int numSets, int ways)
+        : counters(TABLE_ENTRIES, 0), window(static_cast<long long>(numSets) * ways), accesses(0),
+          bypasses(0), correct(0), wrong(0) {
+        if (numSets > 1) {
+            stride = std::max(1, numSets / SAMPLER_SETS);
+            keyRate = 1;
+            samplerWays = ways;
+            sampler.resize((numSets + stride - 1) / stride);
+        }
+        else {
+            stride = 1;
+            keyRate = std::max(1, ways / SAMPLER_WAYS);
+            samplerWays = std::max(1, ways / keyRate);
+            sampler.resize(1);
+        }
+    }
+
+    // Trains on one lookup of key in set and settles bypass outcomes
+    void observe(int set, long long key) {
+        accesses++;
+        std::unordered_map<long long, long long>::iterator it = pending.find(key);
+        if (it != pending.end()) {
+            wrong++;
+            pending.erase(it);
+        }
+        while (!expiry.empty() && expiry.front().first + window <= accesses) {
+            it = pending.find(expiry.front().second);
+            if (it != pending.end() && it->second == expiry.front().first) {
+                correct++;
+                pending.erase(it);
+            }
+            expiry.pop_front();
+        }
+
+        if (set % stride != 0 || (keyRate > 1 && (static_cast<unsigned long long>(key) * 0x9E3779B97F4A7C15ULL >> 40) % keyRate != 0)) {
+            return;
+        }
+        std::vector<Entry>& entries = sampler[set / stride];
+        int signature = pcSignature(accessContext().pc, TABLE_ENTRIES);
+        for (size_t i = 0; i < entries.size(); ++i) {
+            if (entries[i].key == key) {
+                if (counters[entries[i].signature] > 0) {
+                    counters[entries[i].signature]--;
+                }
+                entries.erase(entries.begin() + i);
+                Entry entry = { key, signature };
+                entries.push_back(entry);
+                return;
+            }
+        }
+        if (static_cast<int>(entries.size()) >= samplerWays) {
+            unsigned char& counter = counters[entries.front().signature];
+            counter = std::min<unsigned char>(counter + 1, DEAD);
+            entries.erase(entries.begin());
+        }
+        Entry entry = { key, signature };
+        entries.push_back(entry);
+    }
+
+    bool predictDead() const {
+        return counters[pcSignature(accessContext().pc, TABLE_ENTRIES)] >= DEAD;
+    }
+
+    void recordBypass(long long key) {
+        bypasses++;
+        pending[key] = accesses;
+        expiry.push_back(std::make_pair(accesses, key));
+    }
+};
+
+const int DeadBlockPredictor::TABLE_ENTRIES;
+const int DeadBlockPredictor::SAMPLER_SETS;
+const int DeadBlockPredictor::SAMPLER_WAYS;
+const unsigned char DeadBlockPredictor::DEAD;
+
+// Associativity of a level with numBlocks blocks; 0 (or anything too large)
+// means fully associative
+int resolveWays(int numBlocks, int requestedWays) {
+    return requestedWays <= 0 ? numBlocks : std::min(requestedWays, numBlocks);
+}
+
+// Geometry, timing and tag store shared by Cache and TLB. Subclasses only
+// decide which key a request maps to. Associativity 0 means fully associative.
+class AssociativeLevel {
+protected:
+    int numBlocks;
+    int ways;
+    int numSets;
+    int accessTime;
+    std::unique_ptr<AssociativeStoreBase<int> > store;
+    MissFilteredStore<int>* missFilter;  // Owned by store, null without a filter
+    PartitionedStore* partitions;        // Owned by store, null unless partitioned
+    std::unique_ptr<DeadBlockPredictor> deadBlocks;  // Null unless dead blocks bypass this level
+    int evicted;                         // Key displaced by the last miss, -1 if none
+
+    AssociativeLevel(int blocks, int w, int at, ReplacementPolicy rp, bool filterMisses)
+        : numBlocks(std::max(1, blocks)), ways(resolveWays(numBlocks, w)),
+          numSets(numBlocks / ways), accessTime(at),
+          store(makeAssociativeStore<int>(numSets, ways, rp)), missFilter(nullptr), partitions(nullptr),
+          evicted(-1) {
+        if (filterMisses && numBlocks >= MISS_FILTER_MIN_BLOCKS) {
+            missFilter = new MissFilteredStore<int>(std::move(store), numBlocks);
+            store.reset(missFilter);
+        }
+    }
+
+    // Returns the access time on a hit, -1 on a miss (the key is filled
+    // unless it is predicted dead)
+    int lookup(int key) {
+        if (deadBlocks) {
+            deadBlocks->observe(key % numSets, key);
+        }
+        if (store->touch(key)) {
+            evicted = -1;
+            return accessTime;
+        }
+        if (deadBlocks && deadBlocks->predictDead()) {
+            deadBlocks->recordBypass(key);
+            evicted = -1;
+            return -1;
+        }
+        evicted = store->fill(key);
+        return -1;
+    }
+
+public:
+    int getAccessTime() { return accessTime; }
+
+    // Replaces the tag store with a way-partitioned one; call before any access
+    void enablePartitioning(ReplacementPolicy rp, const PartitionConfig& config) {
+        if (ways > 64) {
+            std::cerr << "Way partitioning supports at most 64 ways; level left unpartitioned.\n";
+            return;
+        }
+        partitions = new PartitionedStore(numSets, ways, rp, config);
+        store.reset(partitions);
+        if (missFilter) {
+            missFilter = new MissFilteredStore<int>(std::move(store), numBlocks);
+            store.reset(missFilter);
+        }
+    }
+
+    // Misses predicted dead are no longer filled
+    void enableDeadBlockBypass() {
+        deadBlocks.reset(new DeadBlockPredictor(numSets, ways));
+    }
+    // Block (or page) number evicted by the last miss, -1 if a free slot was used
+    int lastEvicted() { return evicted; }
+
+    void reportMissFilter(const std::string& name) const {
+        if (!missFilter || missFilter->lookups == 0) {
+            return;
+        }
+        std::cout << name << " fast-miss filter: " << missFilter->filteredMisses << " of "
+            << missFilter->lookups << " lookups answered without a tag probe ("
+            << missFilter->falsePositives << " false positives)\n";
+    }
+
+    void reportPartitions(const std::string& name) const {
+        if (partitions) {
+            partitions->report(name);
+        }
+    }
+
+    void reportBypass(const std::string& name) const {
+        if (!deadBlocks) {
+            return;
+        }
+        long long resolved = deadBlocks->correct + deadBlocks->wrong;
+        std::cout << name << " Dead-Block Bypasses: " << deadBlocks->bypasses << " (Accuracy: " << std::fixed
+            << std::setprecision(2) << (resolved > 0 ? static_cast<double>(deadBlocks->correct) / resolved * 100 : 0.0)
+            << "% of " << resolved << " resolved)\n";
+    }
+
+    // Partition and bypass statistics; lookups are counted by the analyzer
+    void statistics(const std::string& name, RunStatistics& out) const {
+        if (partitions) {
+            partitions->statistics(name, out);
+        }
+        if (deadBlocks) {
+            out.add(name + " Dead-Block Bypasses", static_cast<double>(deadBlocks->bypasses));
+        }
+    }
+};
+
+// Cache class
+class Cache : public AssociativeLevel {
+private:
+    int size;
+    int blockSize;
+
+public:
+    Cache(int s = 0, int bs = 1, int at = 0, ReplacementPolicy rp = FIFO, int w = 1, bool filterMisses = false)
+        : AssociativeLevel(s / bs, w, at, rp, filterMisses), size(s), blockSize(bs) {}
+
+    int access(int address) {
+        return lookup(address / blockSize);  // Access time on a hit, -1 on a miss
+    }
+};
+
+// TLB class
+class TLB : public AssociativeLevel {
+private:
+    int size;
+
+public:
+    TLB(int s = DEFAULT_TLB_SIZE, int at = 0, ReplacementPolicy rp = FIFO, int w = 1, bool filterMisses = false)
+        : AssociativeLevel(s, w, at, rp, filterMisses), size(s) {}
+
+    int access(int page) {
+        return lookup(page);  // Access time on a hit, -1 on a miss
+    }
+
+    int getSize() { return size; }
+};
+
+// Running totals of a PerformanceAnalyzer, kept as doubles so that the
+// totals of sampled runs can be weighted and summed
+struct AnalyzerTotals {
+    double requests;
+    double latency;
+    std::vector<double> hits;    // Per level, indexed like the analyzer's levels
+    std::vector<double> misses;
+
+    void add(const AnalyzerTotals& other) {
+        requests += other.requests;
+        latency += other.latency;
+        for (size_t i = 0; i < hits.size(); ++i) {
+            hits[i] += other.hits[i];
+            misses[i] += other.misses[i];
+        }
+    }
+
+    void subtract(const AnalyzerTotals& other) {
+        AnalyzerTotals negated = other;
+        negated.scale(-1);
+        add(negated);
+    }
+
+    void scale(double factor) {
+        requests *= factor;
+        latency *= factor;
+        for (size_t i = 0; i < hits.size(); ++i) {
+            hits[i] *= factor;
+            misses[i] *= factor;
+        }
+    }
+};
+
+// Performance analyzer class
+//
+// Levels are numbered 0 = TLB (dTLB when L1 is split), 1..n = caches,
+// n + 1 = RAM, n + 2 = disk, then n + 3 = iTLB and n + 4 = L1I. Every
+// lookup is also counted under the class (fetch, load, store) of the access
+// being simulated.
+class PerformanceAnalyzer {
+private:
+    static const int ACCESS_CLASSES = 3;
+
+    int numCaches;
+    bool split;
+    long long totalAccesses;
+    long long hits;
+    long long misses;
+    long long requests;
+    double totalLatency;
+    std::vector<long long> levelHits;
+    std::vector<long long> levelMisses;
+    AccessType current;
+    std::vector<long long> classRequests;
+    std::vector<double> classLatency;
+    std::vector<std::vector<long long> > classHits;
+    std::vector<std::vector<long long> > classMisses;
+    std::vector<long long> latencyCounts;  // Log-spaced buckets, LATENCY_BUCKETS_PER_DOUBLING per doubling
+    std::vector<double> latencyMax;        // Largest latency seen in each bucket
+
+    static const int LATENCY_BUCKETS_PER_DOUBLING = 16;
+
+    static double percent(long long part, long long whole) {
+        return whole == 0 ? 0.0 : static_cast<double>(part) / whole * 100;
+    }
+
+    // Levels in walk order: TLBs, L1s, the remaining caches, then RAM
+    std::vector<int> reportOrder() const {
+        std::vector<int> order(1, 0);
+        if (split) {
+            order.push_back(instructionTlbLevel());
+        }
+        order.push_back(1);
+        if (split) {
+            order.push_back(instructionCacheLevel());
+        }
+        for (int i = 2; i <= numCaches + 1; ++i) {
+            order.push_back(i);
+        }
+        return order;
+    }
+
+public:
+    PerformanceAnalyzer(int caches, bool splitL1)
+        : numCaches(caches), split(splitL1), totalAccesses(0), hits(0), misses(0), requests(0), totalLatency(0),
+          current(LOAD), classRequests(ACCESS_CLASSES, 0), classLatency(ACCESS_CLASSES, 0.0),
+          classHits(ACCESS_CLASSES, std::vector<long long>(caches + 5, 0)),
+          classMisses(ACCESS_CLASSES, std::vector<long long>(caches + 5, 0)) {
+        levelHits.resize(numCaches + 5, 0);
+        levelMisses.resize(numCaches + 5, 0);
+    }
+
+    int instructionTlbLevel() const { return numCaches + 3; }
+    int instructionCacheLevel() const { return numCaches + 4; }
+
+    // Sets the class that following lookups and latencies are counted under
+    void setAccessClass(AccessType type) { current = type; }
+
+    void logAccess(bool hit, int level) {
+        totalAccesses++;
+        if (hit) {
+            hits++;
+            levelHits[level]++;
+            classHits[current][level]++;
+        }
+        else {
+            misses++;
+            levelMisses[level]++;
+            classMisses[current][level]++;
+        }
+    }
+
+    double averageLatency() const { return requests == 0 ? 0.0 : totalLatency / requests; }
+
+    AnalyzerTotals totals() const {
+        AnalyzerTotals result;
+        result.requests = static_cast<double>(requests);
+        result.latency = totalLatency;
+        result.hits.assign(levelHits.begin(), levelHits.end());
+        result.misses.assign(levelMisses.begin(), levelMisses.end());
+        return result;
+    }
+
+    // Misses at a cache level over all lookups that reached the first level
+    // feeding it (L1D alone for a split L1, both L1s below it)
+    double globalMissRatio(int level) const {
+        long long lookups = levelHits[1] + levelMisses[1];
+        if (split && level > 1) {
+            lookups += levelHits[instructionCacheLevel()] + levelMisses[instructionCacheLevel()];
+        }
+        return lookups == 0 ? 0.0 : static_cast<double>(levelMisses[level]) / lookups;
+    }
+
+    // Records the total access time of one simulated address
+    void logLatency(double latency) {
+        size_t bucket = static_cast<size_t>(std::log2(1 + std::max(0.0, latency)) * LATENCY_BUCKETS_PER_DOUBLING);
+        if (bucket >= latencyCounts.size()) {
+            latencyCounts.resize(bucket + 1, 0);
+            latencyMax.resize(bucket + 1, 0.0);
+        }
+        latencyCounts[bucket]++;
+        latencyMax[bucket] = std::max(latencyMax[bucket], latency);
+        requests++;
+        totalLatency += latency;
+        classRequests[current]++;
+        classLatency[current] += latency;
+    }
+
+    // Latency at or below which a fraction p of accesses completed, to
+    // within one bucket (about 4%)
+    double latencyPercentile(double p) const {
+        long long rank = static_cast<long long>(std::ceil(p * requests));
+        long long seen = 0;
+        for (size_t i = 0; i < latencyCounts.size(); ++i) {
+            seen += latencyCounts[i];
+            if (seen >= rank && latencyCounts[i] > 0) {
+                return latencyMax[i];
+            }
+        }
+        return 0.0;
+    }
+
+    std::string levelName(int level) const {
+        if (level == 0) {
+            return split ? "dTLB" : "TLB";
+        }
+        if (level == 1 && split) {
+            return "L1D Cache";
+        }
+        if (level <= numCaches) {
+            return "L" + std::to_string(level) + " Cache";
+        }
+        if (level == instructionTlbLevel()) {
+            return "iTLB";
+        }
+        if (level == instructionCacheLevel()) {
+            return "L1I Cache";
+        }
+        return level == numCaches + 1 ? "RAM" : "Disk";
+    }
+
+    void statistics(RunStatistics& out) const {
+        AnalyzerTotals run = totals();
+        out.add("Average Access Time (ms)", run.requests > 0 ? run.latency / run.requests : 0.0);
+        out.add("Access Time p50 (ms)", latencyPercentile(0.5));
+        out.add("Access Time p99 (ms)", latencyPercentile(0.99));
+        out.add("Access Time p99.9 (ms)", latencyPercentile(0.999));
+        std::vector<int> order = reportOrder();
+        for (size_t k = 0; k < order.size(); ++k) {
+            int i = order[k];
+            double lookups = run.hits[i] + run.misses[i];
+            out.add(levelName(i) + " Hit Rate (%)", lookups > 0 ? run.hits[i] / lookups * 100 : 0.0);
+        }
+        out.add("Disk Accesses", run.hits[numCaches + 2]);
+    }
+
+    void report() const {
+        std::cout << "\nPerformance Report:\n";
+        std::cout << "Total Accesses: " << totalAccesses << "\n";
+        std::cout << "Total Hits: " << hits << "\n";
+        std::cout << "Total Misses: " << misses << "\n";
+        std::cout << "Overall Hit Rate: " << std::fixed << std::setprecision(2)
+            << percent(hits, totalAccesses) << "%\n";
+        std::cout << "Overall Miss Rate: " << std::fixed << std::setprecision(2)
+            << percent(misses, totalAccesses) << "%\n";
+        std::cout << "Average Access Time: " << std::fixed << std::setprecision(2)
+            << (requests == 0 ? 0.0 : totalLatency / requests)
+            << "ms over " << requests << " addresses\n";
+        std::cout << "Access Time Percentiles: p50 " << latencyPercentile(0.5) << "ms, p99 "
+            << latencyPercentile(0.99) << "ms, p99.9 " << latencyPercentile(0.999) << "ms\n";
+
+        std::vector<int> order = reportOrder();
+        for (size_t k = 0; k < order.size(); ++k) {
+            int i = order[k];
+            long long lookups = levelHits[i] + levelMisses[i];
+            std::cout << levelName(i) << " Hit Rate: " << std::fixed << std::setprecision(2)
+                << percent(levelHits[i], lookups) << "%\n";
+            std::cout << levelName(i) << " Miss Rate: " << std::fixed << std::setprecision(2)
+                << percent(levelMisses[i], lookups) << "%\n";
+        }
+        std::cout << "Disk Accesses: " << levelHits[numCaches + 2] << "\n";
+
+        // Only broken down once the run mixes classes
+        int classesSeen = 0;
+        for (int c = 0; c < ACCESS_CLASSES; ++c) {
+            classesSeen += classRequests[c] > 0 ? 1 : 0;
+        }
+        if (classesSeen < 2) {
+            return;
+        }
+        const char* classNames[ACCESS_CLASSES] = {"Loads", "Stores", "Instruction Fetches"};
+        for (int c = 0; c < ACCESS_CLASSES; ++c) {
+            if (classRequests[c] == 0) {
+                continue;
+            }
+            std::cout << classNames[c] << ": " << classRequests[c] << ", Average Access Time: " << std::fixed
+                << std::setprecision(2) << classLatency[c] / classRequests[c] << "ms\n";
+            for (size_t k = 0; k < order.size(); ++k) {
+                int i = order[k];
+                long long lookups = classHits[c][i] + classMisses[c][i];
+                if (lookups > 0) {
+                    std::cout << "  " << levelName(i) << " Hit Rate: " << percent(classHits[c][i], lookups) << "%\n";
+                }
+            }
+        }
+    }
+};
+
+// Configuration of one store-backed level. For the TLB, size is the number
+// of entries and blockSize is unused.
+struct LevelConfig {
+    int size;
+    int blockSize;
+    int accessTime;
+    ReplacementPolicy policy;
+    int ways;
+    bool bypassDead;  // Caches below L1 only: skip filling blocks predicted dead
+};
+
+enum LatencyShape {
+    FIXED_LATENCY,
+    UNIFORM_LATENCY,
+    LOGNORMAL_LATENCY,
+    EMPIRICAL_LATENCY
+};
+
+// Distribution of a level's access time around its configured access time.
+// Uniform draws from access time +/- spread, lognormal has the access time as
+// its median, and empirical draws latencies in proportion to their weights.
+struct LatencyConfig {
+    LatencyShape shape;
+    double spread;                // Uniform, in ms
+    double sigma;                 // Lognormal, standard deviation of the log
+    std::vector<double> values;   // Empirical latencies, in ms
+    std::vector<double> weights;
+};
+
+enum PagePlacement {
+    FIRST_TOUCH,
+    INTERLEAVE,
+    BIND
+};
+
+// One NUMA memory node. Bandwidths are in bytes per ms; 0 means unlimited.
+struct MemoryNodeConfig {
+    int localAccessTime;
+    int remoteAccessTime;
+    int localBandwidth;
+    int remoteBandwidth;
+};
+
+// NUMA layout. With fewer than two nodes RAM keeps its own access time.
+struct NumaConfig {
+    std::vector<MemoryNodeConfig> nodes;
+    std::vector<int> homeNodes;  // Home node of each core
+    PagePlacement placement;
+    int bindNode;
+};
+
+// One memory tier. Capacity is in RAM pages; bandwidth in bytes per ms (0 = unlimited).
+struct TierConfig {
+    std::string name;
+    int capacityPages;
+    int accessTime;
+    int bandwidth;
+};
+
+// Tiered main memory, fastest tier first. Tiering is active with two or more tiers.
+struct TieringConfig {
+    std::vector<TierConfig> tiers;
+    int epochLength;    // Memory accesses between migration passes
+    int hotThreshold;   // Accesses within one epoch that make a page hot
+    int maxMigrations;  // Promotions per migration pass
+};
+
+// CXL.mem memory expander below RAM. Size is in bytes, times in ms and the
+// link bandwidth in bytes per ms (0 = unlimited).
+struct CxlConfig {
+    bool enabled;
+    int size;
+    int mediaAccessTime;
+    ReplacementPolicy policy;
+    int linkLatency;      // One way, per request or response
+    int linkBandwidth;
+    int flitSize;         // Bytes on the wire per flit
+    int flitPayload;      // Data bytes carried per flit
+    int deviceCacheSize;  // 0 = no device-side cache
+    int deviceCacheAccessTime;
+};
+
+enum BackingStoreType {
+    LOCAL_DISK,
+    REMOTE_MEMORY,
+    HDD,
+    SSD
+};
+
+// Disaggregated memory reached over an RDMA-like fabric. A page fetch takes
+// baseLatency plus exponentially distributed jitter with mean jitterMean, and
+// with probability tailProbability an extra tailLatency (congestion,
+// retransmission). Times in ms.
+struct RemoteMemoryConfig {
+    int baseLatency;
+    double jitterMean;
+    double tailProbability;
+    int tailLatency;
+    int prefetchPages;     // Neighbouring pages fetched along with each demand fetch
+    int localCachePages;   // Local page cache holding fetched and prefetched pages
+    int localCacheAccessTime;
+};
+
+// Hard disk: seek time grows with the square root of the LBA distance from
+// the previous request, plus rotational latency unless the request continues
+// the previous one. Times in ms, transfer rate in bytes per ms.
+struct HddConfig {
+    int rpm;
+    double minSeekTime;
+    double maxSeekTime;
+    double transferRate;
+};
+
+// Flash SSD: pages are striped over channels and dies; each die serves one
+// operation at a time and at most queueDepth requests are in flight. Every
+// gcInterval page writes a garbage-collection pass stalls the device. Times
+// in ms, channel bandwidth in bytes per ms.
+struct SsdConfig {
+    int channels;
+    int diesPerChannel;
+    int queueDepth;
+    double readTime;
+    double writeTime;
+    double channelBandwidth;
+    int gcInterval;
+    double gcStallTime;
+};
+
+// OS page cache in front of the backing store. A miss that continues the
+// previous one is treated as sequential: it reads a readahead window that
+// doubles on every sequential miss or readahead hit up to maxWindow, and
+// resets on a random miss. Dirty pages are flushed in the background above
+// backgroundDirtyPercent of capacity and the writer is throttled above
+// dirtyPercent. Window sizes in pages, time in ms.
+struct PageCacheConfig {
+    bool enabled;
+    int capacityPages;
+    int accessTime;
+    int initialWindow;
+    int maxWindow;
+    int backgroundDirtyPercent;
+    int dirtyPercent;
+};
+
+enum DrainPolicy {
+    EAGER_DRAIN,  // Stores drain as soon as they enter the buffer
+    LAZY_DRAIN    // Stores wait until the buffer is half full, giving coalescing a chance
+};
+
+// Per-core store buffer; depth 0 makes stores block like loads. Drained
+// stores merge into block-sized write-combining buffers, which write a whole
+// block into the hierarchy when evicted.
+struct StoreBufferConfig {
+    int depth;
+    int accessTime;
+    int combiningBuffers;  // 0 = drained stores go straight to the hierarchy
+    DrainPolicy drainPolicy;
+};
+
+// What sits below main memory. LOCAL_DISK uses the constant disk access time.
+struct BackingStoreConfig {
+    BackingStoreType type;
+    RemoteMemoryConfig remote;
+    HddConfig hdd;
+    SsdConfig ssd;
+    PageCacheConfig pageCache;
+};
+
+// Full hierarchy configuration. With splitL1, caches[0] and tlb serve loads
+// and stores while l1i and itlb serve instruction fetches; both L1s feed
+// caches[1] onwards.
+struct HierarchyConfig {
+    std::vector<LevelConfig> caches;
+    LevelConfig ram;
+    LevelConfig tlb;
+    bool splitL1;
+    LevelConfig l1i;
+    LevelConfig itlb;
+    int diskSize;
+    int diskAccessTime;
+    LatencyConfig ramLatency;   // Plain RAM only, not NUMA nodes or tiers
+    LatencyConfig diskLatency;  // Constant-time disk only, not device models
+    bool filterMisses;
+    NumaConfig numa;
+    TieringConfig tiering;
+    CxlConfig cxl;
+    BackingStoreConfig backing;
+    StoreBufferConfig storeBuffer;
+    PartitionConfig partition;
+    int workingSetWindow;  // Accesses per working-set window, 0 = off
+    int cores;             // Cores issuing accesses, each with its own store buffer
+};
+
+// Levels built at runtime from a HierarchyConfig
+class RuntimeLevels {
+private:
+    std::vector<Cache> caches;
+    TLB tlb;
+    Cache ram;
+    std::unique_ptr<Cache> l1i;  // Null unless L1 is split
+    std::unique_ptr<TLB> itlb;
+    int diskTime;
+    int page;
+
+public:
+    explicit RuntimeLevels(const HierarchyConfig& config)
+        : tlb(config.tlb.size, config.tlb.accessTime, config.tlb.policy, config.tlb.ways, config.filterMisses),
+          ram(config.ram.size, config.ram.blockSize, config.ram.accessTime, config.ram.policy, config.ram.ways,
+              config.filterMisses),
+          diskTime(config.diskAccessTime), page(std::max(1, config.caches[0].blockSize)) {
+        for (size_t i = 0; i < config.caches.size(); ++i) {
+            const LevelConfig& level = config.caches[i];
+            caches.emplace_back(level.size, level.blockSize, level.accessTime, level.policy, level.ways,
+                config.filterMisses);
+            if (static_cast<int>(i) + 1 == config.partition.level) {
+                caches.back().enablePartitioning(level.policy, config.partition);
+            }
+            if (i > 0 && level.bypassDead) {
+                caches.back().enableDeadBlockBypass();
+            }
+        }
+        if (config.splitL1) {
+            l1i.reset(new Cache(config.l1i.size, config.l1i.blockSize, config.l1i.accessTime, config.l1i.policy,
+                config.l1i.ways, config.filterMisses));
+            itlb.reset(new TLB(config.itlb.size, config.itlb.accessTime, config.itlb.policy, config.itlb.ways,
+                config.filterMisses));
+        }
+    }
+
+    int cacheCount() const { return static_cast<int>(caches.size()); }
+    int pageSize() const { return page; }
+    bool accessTlb(int pageNumber) { return tlb.access(pageNumber) != -1; }
+    int tlbAccessTime() { return tlb.getAccessTime(); }
+    bool accessCache(int i, int address) { return caches[i].access(address) != -1; }
+    int cacheAccessTime(int i) { return caches[i].getAccessTime(); }
+    bool accessRam(int address) { return ram.access(address) != -1; }
+    int ramEvicted() { return ram.lastEvicted(); }
+    int ramAccessTime() { return ram.getAccessTime(); }
+    int diskAccessTime() const { return diskTime; }
+    bool splitL1() const { return l1i != nullptr; }
+    bool accessInstructionTlb(int pageNumber) { return itlb->access(pageNumber) != -1; }
+    int instructionTlbAccessTime() { return itlb->getAccessTime(); }
+    bool accessInstructionCache(int address) { return l1i->access(address) != -1; }
+    int instructionCacheAccessTime() { return l1i->getAccessTime(); }
+
+    // Per-level extras: fast-miss filters, partitions and dead-block bypass
+    void reportLevels() const {
+        for (size_t i = 0; i < caches.size(); ++i) {
+            std::string name = i == 0 && l1i ? "L1D Cache" : "L" + std::to_string(i + 1) + " Cache";
+            caches[i].reportMissFilter(name);
+            caches[i].reportPartitions(name);
+            caches[i].reportBypass(name);
+        }
+        ram.reportMissFilter("RAM");
+        tlb.reportMissFilter(itlb ? "dTLB" : "TLB");
+        if (l1i) {
+            l1i->reportMissFilter("L1I Cache");
+            itlb->reportMissFilter("iTLB");
+        }
+    }
+
+    void levelStatistics(RunStatistics& out) const {
+        for (size_t i = 0; i < caches.size(); ++i) {
+            caches[i].statistics(i == 0 && l1i ? "L1D Cache" : "L" + std::to_string(i + 1) + " Cache", out);
+        }
+    }
+};
+
+// NUMA main memory
+//
+// Places every RAM page on a node according to the placement policy and
+// prices each access by whether that node is the issuing core's home node:
+// the node's local or remote access time plus the time to move one block of
+// the last cache level at the matching bandwidth. Placement is per page and
+// sticks for the whole run.
+class NumaMemory {
+private:
+    NumaConfig config;
+    int pageSize;
+    int transferSize;
+    std::unordered_map<int, int> pageNodes;
+    std::vector<long long> localAccesses;
+    std::vector<long long> remoteAccesses;
+
+    int nodeOf(int page, int home) {
+        std::unordered_map<int, int>::iterator it = pageNodes.find(page);
+        if (it != pageNodes.end()) {
+            return it->second;
+        }
+        int node = home;
+        if (config.placement == INTERLEAVE) {
+            node = page % static_cast<int>(config.nodes.size());
+        }
+        else if (config.placement == BIND) {
+            node = config.bindNode;
+        }
+        pageNodes[page] = node;
+        return node;
+    }
+
+public:
+    NumaMemory(const HierarchyConfig& hierarchy)
+        : config(hierarchy.numa), pageSize(std::max(1, hierarchy.ram.blockSize)),
+          transferSize(hierarchy.caches.back().blockSize),
+          localAccesses(hierarchy.numa.nodes.size(), 0), remoteAccesses(hierarchy.numa.nodes.size(), 0) {
+        if (config.homeNodes.empty()) {
+            config.homeNodes.push_back(0);
+        }
+    }
+
+    bool enabled() const { return config.nodes.size() > 1; }
+    int coreCount() const { return static_cast<int>(config.homeNodes.size()); }
+
+    // Returns the time for core to reach address in main memory
+    double accessTime(int address, int core) {
+        int home = config.homeNodes[core % config.homeNodes.size()];
+        int node = nodeOf(address / pageSize, home);
+        const MemoryNodeConfig& memory = config.nodes[node];
+        bool local = (node == home);
+        int latency = local ? memory.localAccessTime : memory.remoteAccessTime;
+        int bandwidth = local ? memory.localBandwidth : memory.remoteBandwidth;
+        if (local) {
+            localAccesses[node]++;
+        }
+        else {
+            remoteAccesses[node]++;
+        }
+        return latency + (bandwidth > 0 ? static_cast<double>(transferSize) / bandwidth : 0.0);
+    }
+
+    void report() const {
+        if (!enabled()) {
+            return;
+        }
+        long long local = 0;
+        long long remote = 0;
+        for (size_t i = 0; i < config.nodes.size(); ++i) {
+            std::cout << "NUMA Node " << i << ": " << localAccesses[i] << " local, "
+                << remoteAccesses[i] << " remote accesses\n";
+            local += localAccesses[i];
+            remote += remoteAccesses[i];
+        }
+        std::cout << "NUMA Local Access Rate: " << std::fixed << std::setprecision(2)
+            << (local + remote == 0 ? 0.0 : static_cast<double>(local) / (local + remote) * 100) << "%\n";
+    }
+
+    void statistics(RunStatistics& out) const {
+        if (!enabled()) {
+            return;
+        }
+        long long local = 0;
+        long long remote = 0;
+        for (size_t i = 0; i < config.nodes.size(); ++i) {
+            out.add("NUMA Node " + std::to_string(i) + " Local Accesses", static_cast<double>(localAccesses[i]));
+            out.add("NUMA Node " + std::to_string(i) + " Remote Accesses", static_cast<double>(remoteAccesses[i]));
+            local += localAccesses[i];
+            remote += remoteAccesses[i];
+        }
+        out.add("NUMA Local Access Rate (%)",
+            local + remote == 0 ? 0.0 : static_cast<double>(local) / (local + remote) * 100);
+    }
+};
+
+// Tiered main memory
+//
+// Pages are placed on first touch in the fastest tier with room (the slowest
+// tier absorbs any overflow) and counted per epoch. Every epochLength memory
+// accesses a migration pass promotes the hottest pages of slower tiers that
+// reached hotThreshold by one tier, demoting the target tier's least recently
+// used page into the freed frame when the target is full. Each migration
+// copies a page out of one tier and into another; that time is charged to
+// the access that triggered the pass, as synchronous kernel migration would be.
+class TieredMemory {
+private:
+    struct PageState {
+        int tier;
+        long long epoch;
+        int epochAccesses;
+        std::list<int>::iterator position;  // In its tier's recency list
+    };
+
+    TieringConfig config;
+    int pageSize;
+    int transferSize;
+    std::unordered_map<int, PageState> pages;
+    std::vector<std::list<int> > recency;  // Per tier, most recent first
+    std::vector<int> hotPages;             // Pages that reached the threshold this epoch
+    std::vector<long long> tierAccesses;
+    long long epoch;
+    long long accessesThisEpoch;
+    long long promotions;
+    long long demotions;
+    double migrationTime;
+
+    static double transferTime(int bytes, int bandwidth) {
+        return bandwidth > 0 ? static_cast<double>(bytes) / bandwidth : 0.0;
+    }
+
+    int lastTier() const { return static_cast<int>(config.tiers.size()) - 1; }
+
+    bool full(int tier) const {
+        return tier != lastTier() && static_cast<int>(recency[tier].size()) >= config.tiers[tier].capacityPages;
+    }
+
+    void moveTo(int page, PageState& state, int tier) {
+        const TierConfig& from = config.tiers[state.tier];
+        const TierConfig& to = config.tiers[tier];
+        migrationTime += from.accessTime + transferTime(pageSize, from.bandwidth)
+            + to.accessTime + transferTime(pageSize, to.bandwidth);
+        recency[state.tier].erase(state.position);
+        recency[tier].push_front(page);
+        state.position = recency[tier].begin();
+        state.tier = tier;
+    }
+
+    static bool hotter(const std::pair<int, int>& a, const std::pair<int, int>& b) {
+        return a.first > b.first;
+    }
+
+    // Returns the time spent migrating
+    double migrate() {
+        std::vector<std::pair<int, int> > candidates;  // (accesses, page)
+        for (size_t i = 0; i < hotPages.size(); ++i) {
+            // Pages RAM evicted since they turned hot are no longer tracked
+            std::unordered_map<int, PageState>::const_iterator it = pages.find(hotPages[i]);
+            if (it != pages.end() && it->second.tier > 0 && it->second.epoch == epoch) {
+                candidates.push_back(std::make_pair(it->second.epochAccesses, hotPages[i]));
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), hotter);
+
+        double before = migrationTime;
+        int budget = std::min(static_cast<int>(candidates.size()), config.maxMigrations);
+        for (int i = 0; i < budget; ++i) {
+            int page = candidates[i].second;
+            PageState& state = pages.find(page)->second;
+            int source = state.tier;
+            int target = source - 1;
+            if (full(target)) {
+                if (recency[target].empty()) {
+                    continue;
+                }
+                int coldPage = recency[target].back();
+                moveTo(coldPage, pages[coldPage], source);
+                demotions++;
+            }
+            moveTo(page, state, target);
+            promotions++;
+        }
+
+        hotPages.clear();
+        epoch++;
+        accessesThisEpoch = 0;
+        return migrationTime - before;
+    }
+
+public:
+    TieredMemory(const HierarchyConfig& hierarchy)
+        : config(hierarchy.tiering), pageSize(std::max(1, hierarchy.ram.blockSize)),
+          transferSize(hierarchy.caches.back().blockSize), recency(hierarchy.tiering.tiers.size()),
+          tierAccesses(hierarchy.tiering.tiers.size(), 0), epoch(0), accessesThisEpoch(0),
+          promotions(0), demotions(0), migrationTime(0) {}
+
+    bool enabled() const { return config.tiers.size() > 1; }
+
+    // Returns the time to reach address, plus any migration pass it triggers
+    double accessTime(int address) {
+        int page = address / pageSize;
+        std::unordered_map<int, PageState>::iterator it = pages.find(page);
+        if (it == pages.end()) {
+            PageState state;
+            state.tier = 0;
+            while (full(state.tier)) {
+                state.tier++;
+            }
+            state.epoch = epoch;
+            state.epochAccesses = 0;
+            recency[state.tier].push_front(page);
+            state.position = recency[state.tier].begin();
+            it = pages.insert(std::make_pair(page, state)).first;
+        }
+        else {
+            recency[it->second.tier].splice(recency[it->second.tier].begin(), recency[it->second.tier],
+                it->second.position);
+        }
+
+        PageState& state = it->second;
+        if (state.epoch != epoch) {
+            state.epoch = epoch;
+            state.epochAccesses = 0;
+        }
+        if (++state.epochAccesses == config.hotThreshold && state.tier > 0) {
+            hotPages.push_back(page);
+        }
+
+        const TierConfig& tier = config.tiers[state.tier];
+        tierAccesses[state.tier]++;
+        double time = tier.accessTime + transferTime(transferSize, tier.bandwidth);
+        if (++accessesThisEpoch >= config.epochLength) {
+            time += migrate();
+        }
+        return time;
+    }
+
+    // A page left RAM; free its frame
+    void evict(int page) {
+        std::unordered_map<int, PageState>::iterator it = pages.find(page);
+        if (it != pages.end()) {
+            recency[it->second.tier].erase(it->second.position);
+            pages.erase(it);
+        }
+    }
+
+    void report() const {
+        if (!enabled()) {
+            return;
+        }
+        long long total = 0;
+        for (size_t i = 0; i < tierAccesses.size(); ++i) {
+            total += tierAccesses[i];
+        }
+        for (size_t i = 0; i < config.tiers.size(); ++i) {
+            std::cout << "Tier " << config.tiers[i].name << ": " << tierAccesses[i] << " accesses ("
+                << std::fixed << std::setprecision(2)
+                << (total == 0 ? 0.0 : static_cast<double>(tierAccesses[i]) / total * 100) << "%), "
+                << recency[i].size() << " pages resident\n";
+        }
+        std::cout << "Tier Promotions: " << promotions << ", Demotions: " << demotions << "\n";
+        std::cout << "Migration Traffic: " << (promotions + demotions) * static_cast<long long>(pageSize)
+            << " bytes, Migration Time: " << std::fixed << std::setprecision(2) << migrationTime << "ms\n";
+    }
+
+    void statistics(RunStatistics& out) const {
+        if (!enabled()) {
+            return;
+        }
+        for (size_t i = 0; i < config.tiers.size(); ++i) {
+            out.add("Tier " + config.tiers[i].name + " Accesses", static_cast<double>(tierAccesses[i]));
+        }
+        out.add("Tier Promotions", static_cast<double>(promotions));
+        out.add("Tier Demotions", static_cast<double>(demotions));
+        out.add("Migration Time (ms)", migrationTime);
+    }
+};
+
+// CXL-attached far memory
+//
+// Sits after RAM in the level chain and holds whole pages, including the ones
+// RAM evicts, so cold data ends up here rather than on disk. On a RAM miss the
+// requested cache line is read over the link: a request and a response
+// crossing the link, the line's flits at link bandwidth, and either the media
+// access time or, on a hit in the optional device-side cache, that cache's
+// access time. Pages missing from the device come from disk and are filled.
+class CxlMemory {
+private:
+    CxlConfig config;
+    int pageSize;
+    int lineSize;
+    Cache pages;
+    Cache deviceCache;
+    long long hits;
+    long long misses;
+    long long deviceCacheHits;
+    long long demotions;
+    double totalLatency;
+
+    double linkTime() const {
+        int payload = std::max(1, config.flitPayload);
+        int flits = (lineSize + payload - 1) / payload;
+        double wire = config.linkBandwidth > 0
+            ? static_cast<double>(flits) * config.flitSize / config.linkBandwidth : 0.0;
+        return 2.0 * config.linkLatency + wire;
+    }
+
+public:
+    CxlMemory(const HierarchyConfig& hierarchy)
+        : config(hierarchy.cxl), pageSize(std::max(1, hierarchy.ram.blockSize)),
+          lineSize(hierarchy.caches.back().blockSize),
+          pages(hierarchy.cxl.enabled ? hierarchy.cxl.size : 1, pageSize, hierarchy.cxl.mediaAccessTime,
+              hierarchy.cxl.policy, 0),
+          deviceCache(hierarchy.cxl.deviceCacheSize > 0 ? hierarchy.cxl.deviceCacheSize : 1, lineSize,
+              hierarchy.cxl.deviceCacheAccessTime, LRU, 0),
+          hits(0), misses(0), deviceCacheHits(0), demotions(0), totalLatency(0) {}
+
+    bool enabled() const { return config.enabled; }
+
+    // Reads the line holding address. Returns true if the device held its
+    // page; time receives the line's access time either way.
+    bool access(int address, double& time) {
+        time = linkTime();
+        if (pages.access(address) == -1) {
+            misses++;
+            return false;
+        }
+        hits++;
+        if (config.deviceCacheSize > 0 && deviceCache.access(address) != -1) {
+            deviceCacheHits++;
+            time += config.deviceCacheAccessTime;
+        }
+        else {
+            time += config.mediaAccessTime;
+        }
+        totalLatency += time;
+        return true;
+    }
+
+    // A page evicted from RAM moves to the device
+    void demote(int page) {
+        demotions++;
+        pages.access(page * pageSize);
+    }
+
+    void report() const {
+        if (!enabled()) {
+            return;
+        }
+        long long lookups = hits + misses;
+        std::cout << "CXL Memory Hit Rate: " << std::fixed << std::setprecision(2)
+            << (lookups == 0 ? 0.0 : static_cast<double>(hits) / lookups * 100) << "%\n";
+        if (config.deviceCacheSize > 0) {
+            std::cout << "CXL Device Cache Hit Rate: " << std::fixed << std::setprecision(2)
+                << (hits == 0 ? 0.0 : static_cast<double>(deviceCacheHits) / hits * 100) << "%\n";
+        }
+        std::cout << "CXL Average Line Access Time: " << std::fixed << std::setprecision(2)
+            << (hits == 0 ? 0.0 : totalLatency / hits) << "ms\n";
+        std::cout << "Pages Demoted to CXL: " << demotions << "\n";
+    }
+
+    void statistics(RunStatistics& out) const {
+        if (!enabled()) {
+            return;
+        }
+        long long lookups = hits + misses;
+        out.add("CXL Memory Hit Rate (%)", lookups == 0 ? 0.0 : static_cast<double>(hits) / lookups * 100);
+        if (config.deviceCacheSize > 0) {
+            out.add("CXL Device Cache Hit Rate (%)", hits == 0 ? 0.0 : static_cast<double>(deviceCacheHits) / hits * 100);
+        }
+        out.add("CXL Average Line Access Time (ms)", hits == 0 ? 0.0 : totalLatency / hits);
+        out.add("Pages Demoted to CXL", static_cast<double>(demotions));
+    }
+};
+
+// Draws access times from a LatencyConfig with a counter-based generator
+class LatencySampler {
+private:
+    LatencyConfig config;
+    double base;
+    std::vector<double> cumulative;  // Empirical weights, summed
+    unsigned long long seed;
+    unsigned long long drawn;
+
+    double uniform() { return counterUniform(seed, drawn++); }
+
+public:
+    LatencySampler(const LatencyConfig& latency, double accessTime)
+        : config(latency), base(accessTime), seed(nextSeed()), drawn(0) {
+        double sum = 0;
+        for (size_t i = 0; i < config.weights.size(); ++i) {
+            sum += config.weights[i];
+            cumulative.push_back(sum);
+        }
+        if (config.shape == EMPIRICAL_LATENCY && (cumulative.empty() || sum <= 0)) {
+            config.shape = FIXED_LATENCY;
+        }
+    }
+
+    bool fixed() const { return config.shape == FIXED_LATENCY; }
+
+    double sample() {
+        switch (config.shape) {
+        case UNIFORM_LATENCY:
+            return std::max(0.0, base - config.spread + 2 * config.spread * uniform());
+        case LOGNORMAL_LATENCY: {
+            // Box-Muller; 1 - u keeps the logarithm finite
+            double normal = std::sqrt(-2 * std::log(1 - uniform())) * std::cos(2 * std::acos(-1.0) * uniform());
+            return base * std::exp(config.sigma * normal);
+        }
+        case EMPIRICAL_LATENCY: {
+            double target = uniform() * cumulative.back();
+            size_t i = std::upper_bound(cumulative.begin(), cumulative.end(), target) - cumulative.begin();
+            return config.values[std::min(i, config.values.size() - 1)];
+        }
+        case FIXED_LATENCY:
+        default:
+            return base;
+        }
+    }
+};
+
+// Backing store below main memory, used instead of the constant disk access
+// time when configured
+class BackingStore {
+public:
+    virtual ~BackingStore() {}
+    // Returns the time to read (or write) the page holding address
+    virtual double access(int address, bool write) = 0;
+    // Returns the time to serve several pages issued together; devices with
+    // internal parallelism override this
+    virtual double accessBatch(const std::vector<int>& addresses, bool write) {
+        double time = 0;
+        for (size_t i = 0; i < addresses.size(); ++i) {
+            time += access(addresses[i], write);
+        }
+        return time;
+    }
+    virtual void report() const = 0;
+    virtual void statistics(RunStatistics& out) const = 0;
+};
+
+// Remote-memory swap: page-granularity fetches from a far-memory pool
+//
+// Demand misses first check a local page cache, which also receives
+// prefetched neighbouring pages. On a local miss the page is fetched
+// remotely (see RemoteMemoryConfig for the latency model) and the next
+// prefetchPages pages are requested in the same round trip; their transfer
+// overlaps the demand fetch, so they only add traffic.
+class RemoteMemory : public BackingStore {
+private:
+    RemoteMemoryConfig config;
+    int pageSize;
+    Cache localCache;
+    std::unordered_map<int, bool> prefetched;  // Resident pages not yet demanded
+    std::mt19937 rng;
+    std::exponential_distribution<double> jitter;
+    std::uniform_real_distribution<double> unit;
+    long long demandFetches;
+    long long prefetches;
+    long long usefulPrefetches;
+    long long localHits;
+    double fetchTime;
+
+    double fetchLatency() {
+        double latency = config.baseLatency;
+        if (config.jitterMean > 0) {
+            latency += jitter(rng);
+        }
+        if (unit(rng) < config.tailProbability) {
+            latency += config.tailLatency;
+        }
+        return latency;
+    }
+
+public:
+    RemoteMemory(const RemoteMemoryConfig& remote, int page)
+        : config(remote), pageSize(page),
+          localCache(std::max(1, remote.localCachePages) * page, page, remote.localCacheAccessTime, LRU, 0),
+          rng(nextSeed()),
+          jitter(remote.jitterMean > 0 ? 1.0 / remote.jitterMean : 1.0), unit(0.0, 1.0),
+          demandFetches(0), prefetches(0), usefulPrefetches(0), localHits(0), fetchTime(0) {}
+
+    double access(int address, bool) {
+        int page = address / pageSize;
+        if (config.localCachePages > 0 && localCache.access(address) != -1) {
+            localHits++;
+            std::unordered_map<int, bool>::iterator it = prefetched.find(page);
+            if (it != prefetched.end()) {
+                usefulPrefetches++;
+                prefetched.erase(it);
+            }
+            return config.localCacheAccessTime;
+        }
+
+        demandFetches++;
+        double latency = fetchLatency();
+        fetchTime += latency;
+        if (config.localCachePages > 0) {
+            if (localCache.lastEvicted() != -1) {
+                prefetched.erase(localCache.lastEvicted());
+            }
+            for (int i = 1; i <= config.prefetchPages; ++i) {
+                int neighbour = (page + i) * pageSize;
+                if (localCache.access(neighbour) == -1) {
+                    prefetches++;
+                    prefetched[page + i] = true;
+                    if (localCache.lastEvicted() != -1) {
+                        prefetched.erase(localCache.lastEvicted());
+                    }
+                }
+            }
+        }
+        return latency;
+    }
+
+    void report() const {
+        long long requests = demandFetches + localHits;
+        std::cout << "Remote Memory Fetches: " << demandFetches << " demand, " << prefetches << " prefetched ("
+            << usefulPrefetches << " used)\n";
+        std::cout << "Remote Memory Local Page Cache Hit Rate: " << std::fixed << std::setprecision(2)
+            << (requests == 0 ? 0.0 : static_cast<double>(localHits) / requests * 100) << "%\n";
+        std::cout << "Remote Memory Average Fetch Time: " << std::fixed << std::setprecision(2)
+            << (demandFetches == 0 ? 0.0 : fetchTime / demandFetches) << "ms\n";
+        std::cout << "Remote Memory Traffic: " << (demandFetches + prefetches) * static_cast<long long>(pageSize)
+            << " bytes\n";
+    }
+
+    void statistics(RunStatistics& out) const {
+        long long requests = demandFetches + localHits;
+        out.add("Remote Memory Demand Fetches", static_cast<double>(demandFetches));
+        out.add("Remote Memory Prefetches", static_cast<double>(prefetches));
+        out.add("Remote Memory Prefetches Used", static_cast<double>(usefulPrefetches));
+        out.add("Remote Memory Local Page Cache Hit Rate (%)",
+            requests == 0 ? 0.0 : static_cast<double>(localHits) / requests * 100);
+        out.add("Remote Memory Average Fetch Time (ms)", demandFetches == 0 ? 0.0 : fetchTime / demandFetches);
+    }
+};
+
+// Hard disk drive
+class HardDisk : public BackingStore {
+private:
+    HddConfig config;
+    int pageSize;
+    long long totalPages;
+    long long headPage;
+    std::mt19937 rng;
+    std::uniform_real_distribution<double> unit;
+    long long requests;
+    long long sequential;
+    double seekTime;
+    double rotationTime;
+    double transferTime;
+
+public:
+    HardDisk(const HddConfig& hdd, int page, int diskSize)
+        : config(hdd), pageSize(page), totalPages(std::max(1, diskSize / page)), headPage(-2),
+          rng(nextSeed()), unit(0.0, 1.0),
+          requests(0), sequential(0), seekTime(0), rotationTime(0), transferTime(0) {}
+
+    double access(int address, bool) {
+        long long page = (address / pageSize) % totalPages;
+        double time = 0;
+        requests++;
+        if (page == headPage + 1 || page == headPage) {
+            sequential++;
+        }
+        else {
+            double distance = static_cast<double>(std::llabs(page - headPage)) / totalPages;
+            double seek = config.minSeekTime + (config.maxSeekTime - config.minSeekTime) * std::sqrt(std::min(1.0, distance));
+            double rotation = unit(rng) * 60000.0 / std::max(1, config.rpm);
+            seekTime += seek;
+            rotationTime += rotation;
+            time += seek + rotation;
+        }
+        double transfer = config.transferRate > 0 ? pageSize / config.transferRate : 0.0;
+        transferTime += transfer;
+        headPage = page;
+        return time + transfer;
+    }
+
+    // Serves the batch in ascending LBA order, as an elevator scheduler would
+    double accessBatch(const std::vector<int>& addresses, bool write) {
+        std::vector<int> sorted(addresses);
+        std::sort(sorted.begin(), sorted.end());
+        double time = 0;
+        for (size_t i = 0; i < sorted.size(); ++i) {
+            time += access(sorted[i], write);
+        }
+        return time;
+    }
+
+    void report() const {
+        std::cout << "HDD Requests: " << requests << " (" << sequential << " sequential)\n";
+        if (requests > 0) {
+            std::cout << "HDD Average Seek: " << std::fixed << std::setprecision(2) << seekTime / requests
+                << "ms, Rotation: " << rotationTime / requests << "ms, Transfer: " << transferTime / requests << "ms\n";
+        }
+    }
+
+    void statistics(RunStatistics& out) const {
+        out.add("HDD Requests", static_cast<double>(requests));
+        out.add("HDD Sequential Requests", static_cast<double>(sequential));
+        out.add("HDD Average Seek (ms)", requests > 0 ? seekTime / requests : 0.0);
+        out.add("HDD Average Rotation (ms)", requests > 0 ? rotationTime / requests : 0.0);
+        out.add("HDD Average Transfer (ms)", requests > 0 ? transferTime / requests : 0.0);
+    }
+};
+
+// Flash SSD
+class SolidStateDisk : public BackingStore {
+private:
+    SsdConfig config;
+    int pageSize;
+    long long reads;
+    long long writes;
+    long long gcStalls;
+    double busyTime;
+
+    // Time for the requests of one queue-depth window: dies work in parallel,
+    // operations on the same die and transfers on the same channel serialize
+    double window(const std::vector<int>& pages, bool write) {
+        int dies = config.channels * config.diesPerChannel;
+        std::vector<double> dieBusy(dies, 0.0);
+        std::vector<double> channelBusy(config.channels, 0.0);
+        double transfer = config.channelBandwidth > 0 ? pageSize / config.channelBandwidth : 0.0;
+        double stall = 0;
+        for (size_t i = 0; i < pages.size(); ++i) {
+            int channel = pages[i] % config.channels;
+            int die = (pages[i] / config.channels) % config.diesPerChannel;
+            double& busy = dieBusy[channel * config.diesPerChannel + die];
+            busy += write ? config.writeTime : config.readTime;
+            channelBusy[channel] = std::max(channelBusy[channel], busy) + transfer;
+            if (write) {
+                writes++;
+                if (config.gcInterval > 0 && writes % config.gcInterval == 0) {
+                    gcStalls++;
+                    stall += config.gcStallTime;
+                }
+            }
+            else {
+                reads++;
+            }
+        }
+        return *std::max_element(channelBusy.begin(), channelBusy.end()) + stall;
+    }
+
+public:
+    SolidStateDisk(const SsdConfig& ssd, int page)
+        : config(ssd), pageSize(page), reads(0), writes(0), gcStalls(0), busyTime(0) {
+        config.channels = std::max(1, config.channels);
+        config.diesPerChannel = std::max(1, config.diesPerChannel);
+        config.queueDepth = std::max(1, config.queueDepth);
+    }
+
+    double access(int address, bool write) {
+        return accessBatch(std::vector<int>(1, address), write);
+    }
+
+    double accessBatch(const std::vector<int>& addresses, bool write) {
+        double time = 0;
+        for (size_t start = 0; start < addresses.size(); start += config.queueDepth) {
+            std::vector<int> pages;
+            for (size_t i = start; i < addresses.size() && i < start + config.queueDepth; ++i) {
+                pages.push_back(addresses[i] / pageSize);
+            }
+            time += window(pages, write);
+        }
+        busyTime += time;
+        return time;
+    }
+
+    void report() const {
+        std::cout << "SSD Page Reads: " << reads << ", Page Writes: " << writes
+            << ", GC Stalls: " << gcStalls << "\n";
+        std::cout << "SSD Busy Time: " << std::fixed << std::setprecision(2) << busyTime << "ms\n";
+    }
+
+    void statistics(RunStatistics& out) const {
+        out.add("SSD Page Reads", static_cast<double>(reads));
+        out.add("SSD Page Writes", static_cast<double>(writes));
+        out.add("SSD GC Stalls", static_cast<double>(gcStalls));
+        out.add("SSD Busy Time (ms)", busyTime);
+    }
+};
+
+// Plain disk, used when another layer has to wrap it or its access time
+// follows a distribution
+class ConstantDisk : public BackingStore {
+private:
+    LatencySampler latency;
+    long long requests;
+
+public:
+    ConstantDisk(int time, const LatencyConfig& distribution) : latency(distribution, time), requests(0) {}
+
+    double access(int, bool) {
+        requests++;
+        return latency.sample();
+    }
+
+    void report() const {
+        std::cout << "Disk Requests: " << requests << "\n";
+    }
+
+    void statistics(RunStatistics& out) const {
+        out.add("Disk Requests", static_cast<double>(requests));
+    }
+};
+
+// OS page cache with readahead and write-back
+class PageCache : public BackingStore {
+private:
+    struct Entry {
+        std::list<int>::iterator position;  // In recency, most recent at the back
+        bool dirty;
+        bool readahead;                     // Brought in by readahead, not yet used
+    };
+
+    PageCacheConfig config;
+    int pageSize;
+    std::unique_ptr<BackingStore> device;
+    std::list<int> recency;
+    std::unordered_map<int, Entry> pages;
+    int dirtyPages;
+    int lastMiss;
+    int window;
+    long long hits;
+    long long misses;
+    long long readaheadPages;
+    long long usefulReadahead;
+    long long writebacks;
+    long long throttledWrites;
+    double deviceTime;
+
+    // Writes back the dirty pages in LRU order until at most target remain
+    double flush(int target) {
+        std::vector<int> batch;
+        for (std::list<int>::iterator it = recency.begin(); it != recency.end() && dirtyPages > target; ++it) {
+            Entry& entry = pages[*it];
+            if (entry.dirty) {
+                entry.dirty = false;
+                dirtyPages--;
+                batch.push_back(*it * pageSize);
+            }
+        }
+        if (batch.empty()) {
+            return 0;
+        }
+        writebacks += batch.size();
+        double time = device->accessBatch(batch, true);
+        deviceTime += time;
+        return time;
+    }
+
+    // Inserts page, evicting the LRU page if full; returns write-back time
+    double insert(int page, bool readahead) {
+        double time = 0;
+        if (static_cast<int>(pages.size()) >= config.capacityPages) {
+            int victim = recency.front();
+            recency.pop_front();
+            if (pages[victim].dirty) {
+                dirtyPages--;
+                writebacks++;
+                time = device->access(victim * pageSize, true);
+                deviceTime += time;
+            }
+            pages.erase(victim);
+        }
+        Entry entry;
+        entry.position = recency.insert(recency.end(), page);
+        entry.dirty = false;
+        entry.readahead = readahead;
+        pages[page] = entry;
+        return time;
+    }
+
+    // Reads the next window of pages after page. A synchronous read is
+    // charged to the caller; asynchronous readahead overlaps with it.
+    double readAhead(int page, bool charge) {
+        std::vector<int> batch;
+        double time = 0;
+        for (int i = 1; i <= window; ++i) {
+            if (pages.find(page + i) == pages.end()) {
+                time += insert(page + i, true);
+                batch.push_back((page + i) * pageSize);
+            }
+        }
+        if (batch.empty()) {
+            return time;
+        }
+        readaheadPages += batch.size();
+        double read = device->accessBatch(batch, false);
+        deviceTime += read;
+        return charge ? time + read : time;
+    }
+
+public:
+    PageCache(const PageCacheConfig& pageCache, int page, std::unique_ptr<BackingStore> inner)
+        : config(pageCache), pageSize(page), device(std::move(inner)), dirtyPages(0), lastMiss(-2),
+          window(pageCache.initialWindow), hits(0), misses(0), readaheadPages(0), usefulReadahead(0),
+          writebacks(0), throttledWrites(0), deviceTime(0) {
+        config.capacityPages = std::max(1, config.capacityPages);
+        config.initialWindow = std::max(0, std::min(config.initialWindow, config.capacityPages / 2));
+        config.maxWindow = std::max(config.initialWindow, std::min(config.maxWindow, config.capacityPages / 2));
+        window = config.initialWindow;
+    }
+
+    double access(int address, bool write) {
+        int page = address / pageSize;
+        double time = config.accessTime;
+        std::unordered_map<int, Entry>::iterator it = pages.find(page);
+        if (it != pages.end()) {
+            hits++;
+            recency.splice(recency.end(), recency, it->second.position);
+            if (it->second.readahead) {
+                // Hitting readahead data confirms the stream: grow the window
+                // and keep reading ahead of the reader
+                it->second.readahead = false;
+                usefulReadahead++;
+                if (!write && pages.find(page + 1) != pages.end() && pages.find(page + window) == pages.end()) {
+                    window = std::min(std::max(1, window * 2), config.maxWindow);
+                    time += readAhead(page, false);
+                }
+            }
+        }
+        else {
+            misses++;
+            time += insert(page, false);
+            if (!write) {
+                // Whole-page writes need no read from the device
+                if (page == lastMiss + 1) {
+                    window = std::min(std::max(1, window * 2), config.maxWindow);
+                }
+                else {
+                    window = config.initialWindow;
+                }
+                double read = device->access(address, false);
+                deviceTime += read;
+                time += read + readAhead(page, true);
+            }
+            lastMiss = page;
+        }
+
+        if (write) {
+            Entry& entry = pages[page];
+            if (!entry.dirty) {
+                entry.dirty = true;
+                dirtyPages++;
+            }
+            int capacity = config.capacityPages;
+            if (config.dirtyPercent > 0 && dirtyPages * 100 > config.dirtyPercent * capacity) {
+                throttledWrites++;
+                time += flush(config.backgroundDirtyPercent * capacity / 100);
+            }
+            else if (config.backgroundDirtyPercent > 0 && dirtyPages * 100 > config.backgroundDirtyPercent * capacity) {
+                flush(config.backgroundDirtyPercent * capacity / 100);
+            }
+        }
+        return time;
+    }
+
+    void report() const {
+        long long total = hits + misses;
+        std::cout << "Page Cache Hit Rate: " << std::fixed << std::setprecision(2)
+            << (total > 0 ? static_cast<double>(hits) / total * 100 : 0.0) << "%\n";
+        std::cout << "Readahead Pages: " << readaheadPages << " (" << usefulReadahead
+            << " used), Final Window: " << window << " pages\n";
+        std::cout << "Page Cache Write-backs: " << writebacks << ", Throttled Writes: " << throttledWrites
+            << ", Dirty Pages: " << dirtyPages << "\n";
+        std::cout << "Page Cache Device Time: " << deviceTime << "ms\n";
+        device->report();
+    }
+
+    void statistics(RunStatistics& out) const {
+        long long total = hits + misses;
+        out.add("Page Cache Hit Rate (%)", total > 0 ? static_cast<double>(hits) / total * 100 : 0.0);
+        out.add("Readahead Pages", static_cast<double>(readaheadPages));
+        out.add("Readahead Pages Used", static_cast<double>(usefulReadahead));
+        out.add("Page Cache Write-backs", static_cast<double>(writebacks));
+        out.add("Page Cache Throttled Writes", static_cast<double>(throttledWrites));
+        out.add("Page Cache Device Time (ms)", deviceTime);
+        device->statistics(out);
+    }
+};
+
+// Returns null for LOCAL_DISK, which keeps the constant disk access time
+std::unique_ptr<BackingStore> makeDevice(const HierarchyConfig& config) {
+    int pageSize = std::max(1, config.ram.blockSize);
+    switch (config.backing.type) {
+    case REMOTE_MEMORY:
+        return std::unique_ptr<BackingStore>(new RemoteMemory(config.backing.remote, pageSize));
+    case HDD:
+        return std::unique_ptr<BackingStore>(new HardDisk(config.backing.hdd, pageSize, config.diskSize));
+    case SSD:
+        return std::unique_ptr<BackingStore>(new SolidStateDisk(config.backing.ssd, pageSize));
+    case LOCAL_DISK:
+    default:
+        return std::unique_ptr<BackingStore>();
+    }
+}
+
+// Wraps the device in the page cache when one is configured
+std::unique_ptr<BackingStore> makeBackingStore(const HierarchyConfig& config) {
+    std::unique_ptr<BackingStore> device = makeDevice(config);
+    if (!device && (config.backing.pageCache.enabled || config.diskLatency.shape != FIXED_LATENCY)) {
+        device.reset(new ConstantDisk(config.diskAccessTime, config.diskLatency));
+    }
+    if (!config.backing.pageCache.enabled) {
+        return device;
+    }
+    return std::unique_ptr<BackingStore>(
+        new PageCache(config.backing.pageCache, std::max(1, config.ram.blockSize), std::move(device)));
+}
+
+// Store buffers and write-combining buffers
+//
+// Each core keeps its own clock, advanced by the latency of its accesses.
+// A store costs the buffer access time, plus a stall when the buffer is full
+// until the oldest entry has drained. Entries drain one at a time in the
+// background; the drain time is that of the write into the hierarchy, or of
+// the write-combining buffer it evicts. Loads to a block still buffered are
+// forwarded without touching the hierarchy.
+class StoreBuffers {
+public:
+    // Writes one block into the hierarchy and returns the time it took
+    typedef std::function<double(int address, int core)> Writer;
+
+private:
+    struct Entry {
+        int address;
+        double completion;  // -1 until the entry starts draining
+    };
+
+    struct CoreBuffers {
+        double clock;
+        double drainFree;             // When the drain path is next free
+        std::deque<Entry> entries;    // Oldest first
+        std::deque<int> combining;    // Blocks held in write-combining buffers, LRU first
+        CoreBuffers() : clock(0), drainFree(0) {}
+    };
+
+    StoreBufferConfig config;
+    int blockSize;
+    int watermark;
+    std::vector<CoreBuffers> cores;
+    long long stores;
+    long long coalesced;
+    long long combined;
+    long long forwarded;
+    long long stalls;
+    double stallTime;
+    long long blockWrites;
+
+    CoreBuffers& buffers(int core) {
+        if (core >= static_cast<int>(cores.size())) {
+            cores.resize(core + 1);
+        }
+        return cores[core];
+    }
+
+    // Moves a drained store into the write-combining buffers
+    double combine(CoreBuffers& c, int address, int core, const Writer& write) {
+        if (config.combiningBuffers <= 0) {
+            blockWrites++;
+            return write(address, core);
+        }
+        int block = address / blockSize;
+        std::deque<int>::iterator it = std::find(c.combining.begin(), c.combining.end(), block);
+        if (it != c.combining.end()) {
+            combined++;
+            c.combining.erase(it);
+            c.combining.push_back(block);
+            return 0;
+        }
+        double time = 0;
+        if (static_cast<int>(c.combining.size()) >= config.combiningBuffers) {
+            blockWrites++;
+            time = write(c.combining.front() * blockSize, core);
+            c.combining.pop_front();
+        }
+        c.combining.push_back(block);
+        return time;
+    }
+
+    // Starts draining the oldest entries until at most keep are waiting
+    void schedule(CoreBuffers& c, int core, size_t keep, const Writer& write) {
+        size_t waiting = 0;
+        for (size_t i = 0; i < c.entries.size(); ++i) {
+            waiting += c.entries[i].completion < 0 ? 1 : 0;
+        }
+        for (size_t i = 0; i < c.entries.size() && waiting > keep; ++i) {
+            Entry& entry = c.entries[i];
+            if (entry.completion < 0) {
+                double start = std::max(c.clock, c.drainFree);
+                entry.completion = start + combine(c, entry.address, core, write);
+                c.drainFree = entry.completion;
+                waiting--;
+            }
+        }
+    }
+
+    // Drops entries whose drain has completed by the core's clock
+    static void retire(CoreBuffers& c) {
+        while (!c.entries.empty() && c.entries.front().completion >= 0 && c.entries.front().completion <= c.clock) {
+            c.entries.pop_front();
+        }
+    }
+
+public:
+    StoreBuffers(const HierarchyConfig& hierarchy)
+        : config(hierarchy.storeBuffer), stores(0), coalesced(0), combined(0), forwarded(0), stalls(0),
+          stallTime(0), blockWrites(0) {
+        blockSize = hierarchy.caches.empty() ? 1 : std::max(1, hierarchy.caches[0].blockSize);
+        watermark = config.drainPolicy == LAZY_DRAIN ? config.depth / 2 : 0;
+    }
+
+    bool enabled() const { return config.depth > 0; }
+
+    // Buffers a store and returns the time the core spends on it
+    double store(int core, int address, const Writer& write) {
+        CoreBuffers& c = buffers(core);
+        stores++;
+        retire(c);
+        int block = address / blockSize;
+        for (size_t i = 0; i < c.entries.size(); ++i) {
+            if (c.entries[i].completion < 0 && c.entries[i].address / blockSize == block) {
+                coalesced++;
+                c.clock += config.accessTime;
+                return config.accessTime;
+            }
+        }
+
+        double stall = 0;
+        if (static_cast<int>(c.entries.size()) >= config.depth) {
+            schedule(c, core, c.entries.size() - 1, write);
+            stall = std::max(0.0, c.entries.front().completion - c.clock);
+            c.clock += stall;
+            c.entries.pop_front();
+            stalls++;
+            stallTime += stall;
+        }
+        Entry entry;
+        entry.address = address;
+        entry.completion = -1;
+        c.entries.push_back(entry);
+        schedule(c, core, watermark, write);
+        c.clock += config.accessTime;
+        return stall + config.accessTime;
+    }
+
+    // True if a load can be served from the core's buffered stores
+    bool forward(int core, int address) {
+        CoreBuffers& c = buffers(core);
+        retire(c);
+        int block = address / blockSize;
+        for (size_t i = 0; i < c.entries.size(); ++i) {
+            if (c.entries[i].address / blockSize == block) {
+                forwarded++;
+                return true;
+            }
+        }
+        if (std::find(c.combining.begin(), c.combining.end(), block) != c.combining.end()) {
+            forwarded++;
+            return true;
+        }
+        return false;
+    }
+
+    int accessTime() const { return config.accessTime; }
+
+    // Advances the core's clock past a load
+    void advance(int core, double time) {
+        buffers(core).clock += time;
+    }
+
+    // Writes out everything still buffered at the end of a run
+    void drain(const Writer& write) {
+        for (size_t core = 0; core < cores.size(); ++core) {
+            CoreBuffers& c = cores[core];
+            schedule(c, static_cast<int>(core), 0, write);
+            c.entries.clear();
+            while (!c.combining.empty()) {
+                blockWrites++;
+                write(c.combining.front() * blockSize, static_cast<int>(core));
+                c.combining.pop_front();
+            }
+        }
+    }
+
+    void report() const {
+        if (!enabled()) {
+            return;
+        }
+        std::cout << "Stores: " << stores << " (" << coalesced << " coalesced in store buffers, "
+            << combined << " combined in write-combining buffers)\n";
+        std::cout << "Store-to-Load Forwards: " << forwarded << "\n";
+        std::cout << "Store Buffer Full Stalls: " << stalls << " (Average stall: " << std::fixed
+            << std::setprecision(2) << (stalls > 0 ? stallTime / stalls : 0.0) << "ms)\n";
+        std::cout << "Write Traffic: " << blockWrites << " blocks (" << blockWrites * blockSize << " bytes)\n";
+    }
+
+    void statistics(RunStatistics& out) const {
+        if (!enabled()) {
+            return;
+        }
+        out.add("Stores", static_cast<double>(stores));
+        out.add("Stores Coalesced", static_cast<double>(coalesced));
+        out.add("Stores Combined", static_cast<double>(combined));
+        out.add("Store-to-Load Forwards", static_cast<double>(forwarded));
+        out.add("Store Buffer Full Stalls", static_cast<double>(stalls));
+        out.add("Store Buffer Average Stall (ms)", stalls > 0 ? stallTime / stalls : 0.0);
+        out.add("Write Traffic (blocks)", static_cast<double>(blockWrites));
+    }
+};
+
+// HyperLogLog distinct-count sketch: 2^HLL_PRECISION one-byte registers
+// (4KB), standard error about 1.04 / sqrt(2^HLL_PRECISION) = 1.6%
+const int HLL_PRECISION = 12;
+
+class HyperLogLog {
+private:
+    std::vector<unsigned char> registers;
+
+    // SplitMix64 finalizer
+    static unsigned long long mix(unsigned long long x) {
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+
+public:
+    HyperLogLog() : registers(1 << HLL_PRECISION, 0) {}
+
+    void add(long long key) {
+        unsigned long long hash = mix(static_cast<unsigned long long>(key));
+        size_t index = hash >> (64 - HLL_PRECISION);
+        unsigned long long rest = hash << HLL_PRECISION;
+        unsigned char rank = 1;
+        while (rank <= 64 - HLL_PRECISION && !(rest & (1ULL << 63))) {
+            rest <<= 1;
+            rank++;
+        }
+        registers[index] = std::max(registers[index], rank);
+    }
+
+    // Raw estimate, with linear counting while registers are still empty
+    double estimate() const {
+        double m = static_cast<double>(registers.size());
+        double sum = 0;
+        int zeros = 0;
+        for (size_t i = 0; i < registers.size(); ++i) {
+            sum += std::ldexp(1.0, -registers[i]);
+            zeros += registers[i] == 0 ? 1 : 0;
+        }
+        double raw = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+        return raw <= 2.5 * m && zeros > 0 ? m * std::log(m / zeros) : raw;
+    }
+
+    void clear() { std::fill(registers.begin(), registers.end(), 0); }
+};
+
+// Working-set time series
+//
+// Estimates the distinct blocks (at the L1 block size, which is also the TLB
+// page size) and RAM pages touched in each window of accesses with
+// HyperLogLog sketches, so memory stays fixed however long the trace is.
+// Windows whose footprint exceeds RAM or the TLB reach are flagged.
+class WorkingSetTracker {
+private:
+    struct Window {
+        long long accesses;
+        double blocks;
+        double pages;
+    };
+
+    long long windowLength;  // 0 = off
+    int blockSize;
+    int pageSize;
+    long long ramBytes;
+    long long tlbReach;      // Blocks the TLB maps
+    HyperLogLog blocks;
+    HyperLogLog pages;
+    HyperLogLog allBlocks;
+    HyperLogLog allPages;
+    long long inWindow;
+    std::vector<Window> series;
+
+    void closeWindow() {
+        Window window = { inWindow, blocks.estimate(), pages.estimate() };
+        series.push_back(window);
+        blocks.clear();
+        pages.clear();
+        inWindow = 0;
+    }
+
+public:
+    explicit WorkingSetTracker(const HierarchyConfig& config)
+        : windowLength(config.workingSetWindow), inWindow(0) {
+        blockSize = config.caches.empty() ? 1 : std::max(1, config.caches[0].blockSize);
+        pageSize = std::max(1, config.ram.blockSize);
+        ramBytes = config.ram.size;
+        tlbReach = config.tlb.size;
+    }
+
+    bool enabled() const { return windowLength > 0; }
+
+    void observe(int address) {
+        if (!enabled()) {
+            return;
+        }
+        blocks.add(address / blockSize);
+        pages.add(address / pageSize);
+        allBlocks.add(address / blockSize);
+        allPages.add(address / pageSize);
+        if (++inWindow == windowLength) {
+            closeWindow();
+        }
+    }
+
+    // Read-only, so a report can be taken mid-run; a partly filled window is
+    // shown as the last row without being closed
+    void report() const {
+        if (!enabled()) {
+            return;
+        }
+        std::vector<Window> shown = series;
+        if (inWindow > 0) {
+            Window open = { inWindow, blocks.estimate(), pages.estimate() };
+            shown.push_back(open);
+        }
+        std::cout << "\nWorking Set (HyperLogLog, windows of " << windowLength << " accesses, +/- "
+            << std::fixed << std::setprecision(1) << 104 / std::sqrt(static_cast<double>(1 << HLL_PRECISION))
+            << "%):\n";
+        std::cout << "Window  Accesses      Blocks       Bytes   RAM Pages       Bytes\n";
+        for (size_t i = 0; i < shown.size(); ++i) {
+            const Window& w = shown[i];
+            std::cout << std::setw(6) << i << std::setw(10) << w.accesses << std::setprecision(0)
+                << std::setw(12) << w.blocks << std::setw(12) << w.blocks * blockSize
+                << std::setw(12) << w.pages << std::setw(12) << w.pages * pageSize
+                << (w.pages * pageSize > ramBytes ? "  exceeds RAM" : "")
+                << (w.blocks > tlbReach ? "  exceeds TLB reach" : "") << "\n";
+        }
+        std::cout << "Whole Run: " << std::setprecision(0) << allBlocks.estimate() << " blocks ("
+            << allBlocks.estimate() * blockSize << " bytes), " << allPages.estimate() << " RAM pages ("
+            << allPages.estimate() * pageSize << " bytes)\n";
+    }
+
+    void statistics(RunStatistics& out) const {
+        if (!enabled()) {
+            return;
+        }
+        out.add("Working Set Blocks", allBlocks.estimate());
+        out.add("Working Set RAM Pages", allPages.estimate());
+    }
+};
+
+// Interface shared by the interpreted hierarchy and specialized simulators
+// loaded from generated shared objects
+class SimulatorInstance {
+public:
+    virtual ~SimulatorInstance() {}
+    // Simulates one access and returns its total access time
+    virtual double simulateAccess(const MemoryAccess& access) = 0;
+    virtual void run(const std::vector<MemoryAccess>& accesses) = 0;
+    virtual void setVerbose(bool on) = 0;
+    virtual void report() const = 0;
+
+    // Generates the pattern and deals its addresses to cores round-robin
+    void runSimulation(const WorkloadConfig& workload, int numCores) {
+        run(generateAccesses(workload, numCores));
+        report();
+    }
+
+    // Replays a trace file (see loadTrace)
+    void runTrace(const std::string& path, int numCores) {
+        std::vector<MemoryAccess> accesses = loadTrace(path, numCores);
+        if (accesses.empty()) {
+            std::cerr << "No accesses found in " << path << "\n";
+            return;
+        }
+        run(accesses);
+        report();
+    }
+};
+
+// Memory hierarchy class
+//
+// Walks each address through the TLB, caches, RAM and disk. Levels supplies
+// the stores: RuntimeLevels builds them from a HierarchyConfig, while
+// generated simulators supply levels with every geometry, policy and latency
+// fixed at compile time.
+template <class Levels>
+class BasicMemoryHierarchy : public SimulatorInstance {
+private:
+    Levels levels;
+    NumaMemory numa;
+    TieredMemory tiers;
+    CxlMemory cxl;
+    std::unique_ptr<BackingStore> backing;  // Null for the constant-time disk
+    StoreBuffers storeBuffers;
+    StoreBuffers::Writer writer;            // Drained stores walk the hierarchy as writes
+    WorkingSetTracker workingSet;
+    LatencySampler ramLatency;
+    PerformanceAnalyzer analyzer;
+    bool verbose;
+
+    // Returns true on a RAM hit; adds the access time of RAM (or of the
+    // page's tier or NUMA node) either way
+    bool accessRam(int address, int core, double& totalTime) {
+        bool hit = levels.accessRam(address);
+        if (!hit && cxl.enabled() && levels.ramEvicted() != -1) {
+            cxl.demote(levels.ramEvicted());
+        }
+        if (tiers.enabled()) {
+            if (!hit && levels.ramEvicted() != -1) {
+                tiers.evict(levels.ramEvicted());
+            }
+            totalTime += tiers.accessTime(address);
+        }
+        else if (numa.enabled()) {
+            totalTime += numa.accessTime(address, core);
+        }
+        else {
+            totalTime += ramLatency.fixed() ? levels.ramAccessTime() : ramLatency.sample();
+        }
+        if (hit) {
+            if (verbose) {
+                std::cout << "Hit in RAM (Access time: " << totalTime << "ms)\n";
+            }
+            analyzer.logAccess(true, levels.cacheCount() + 1);
+            return true;
+        }
+        if (verbose) {
+            std::cout << "Miss in RAM\n";
+        }
+        analyzer.logAccess(false, levels.cacheCount() + 1);
+        return false;
+    }
+
+    // RAM, then CXL memory, then disk
+    void accessMemory(int address, int core, bool write, double& totalTime) {
+        if (accessRam(address, core, totalTime)) {
+            return;
+        }
+        if (cxl.enabled()) {
+            double time;
+            bool hit = cxl.access(address, time);
+            totalTime += time;
+            if (hit) {
+                if (verbose) {
+                    std::cout << "Hit in CXL Memory (Access time: " << totalTime << "ms)\n";
+                }
+                return;
+            }
+            if (verbose) {
+                std::cout << "Miss in CXL Memory\n";
+            }
+        }
+        accessDisk(address, write, totalTime);
+    }
+
+    void accessDisk(int address, bool write, double& totalTime) {
+        double time = backing ? backing->access(address, write) : levels.diskAccessTime();
+        totalTime += time;
+        if (verbose) {
+            std::cout << "Wait...\n";
+            std::cout.flush();
+            std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int>(time)));
+            std::cout << (backing ? "Accessing Backing Store" : "Accessing Disk")
+                << " (Total access time: " << totalTime << "ms)\n";
+        }
+        analyzer.logAccess(true, levels.cacheCount() + 2);
+    }
+
+    // Walks one access through the TLB, caches and memory and returns its
+    // total access time. With a split L1, fetches use the iTLB and L1I.
+    double walk(int address, int core, AccessType type) {
+        bool fetch = type == FETCH && levels.splitL1();
+        double totalTime = 0;
+        if (verbose) {
+            std::cout << "\n\nAddress: " << address
+                << (type == STORE ? " (store)" : type == FETCH ? " (fetch)" : "") << std::endl;
+            std::cout << "Getting Physical address...\n";
+        }
+
+        // Access TLB
+        int tlbLevel = fetch ? analyzer.instructionTlbLevel() : 0;
+        totalTime += fetch ? levels.instructionTlbAccessTime() : levels.tlbAccessTime();
+        int pageNumber = address / levels.pageSize();
+        if (fetch ? levels.accessInstructionTlb(pageNumber) : levels.accessTlb(pageNumber)) {
+            if (verbose) {
+                std::cout << analyzer.levelName(tlbLevel) << " Hit (Access time: " << totalTime << "ms)\n";
+            }
+            analyzer.logAccess(true, tlbLevel);
+        }
+        else {  // TLB miss, walk the page table in main memory
+            if (verbose) {
+                std::cout << analyzer.levelName(tlbLevel)
+                    << " Miss, Accessing RAM to get Physical Address (Access time: " << totalTime << "ms)\n";
+            }
+            analyzer.logAccess(false, tlbLevel);
+            accessMemory(address, core, false, totalTime);
+        }
+
+        // Access caches
+        for (int i = 0; i < levels.cacheCount(); ++i) {
+            int level = i == 0 && fetch ? analyzer.instructionCacheLevel() : i + 1;
+            bool hit;
+            if (i == 0 && fetch) {
+                totalTime += levels.instructionCacheAccessTime();
+                hit = levels.accessInstructionCache(address);
+            }
+            else {
+                totalTime += levels.cacheAccessTime(i);
+                hit = levels.accessCache(i, address);
+            }
+            if (hit) {
+                if (verbose) {
+                    std::cout << "Hit in " << analyzer.levelName(level) << " (Access time: " << totalTime << "ms)\n";
+                }
+                analyzer.logAccess(true, level);
+                return totalTime;  // Stop further accesses
+            }
+            if (verbose) {
+                std::cout << "Miss in " << analyzer.levelName(level) << "\n";
+            }
+            analyzer.logAccess(false, level);
+        }
+
+        // If all caches miss, go to main memory
+        accessMemory(address, core, type == STORE, totalTime);
+        return totalTime;
+    }
+
+public:
+    explicit BasicMemoryHierarchy(const HierarchyConfig& config)
+        : levels(config), numa(config), tiers(config), cxl(config), backing(makeBackingStore(config)),
+          storeBuffers(config), workingSet(config), ramLatency(config.ramLatency, config.ram.accessTime), analyzer(levels.cacheCount(), levels.splitL1()), verbose(true) {
+        writer = [this](int address, int core) {
+            analyzer.setAccessClass(STORE);
+            accessContext().pc = 0;  // Drained stores are write-backs, with no PC of their own
+            accessContext().core = core;
+            return walk(address, core, STORE);
+        };
+    }
+
+    double simulateAccess(const MemoryAccess& access) {
+        double time;
+        analyzer.setAccessClass(access.type);
+        accessContext().pc = access.pc;
+        accessContext().core = access.core;
+        workingSet.observe(access.address);
+        if (!storeBuffers.enabled()) {
+            time = walk(access.address, access.core, access.type);
+        }
+        else if (access.type == STORE) {
+            time = storeBuffers.store(access.core, access.address, writer);
+            if (verbose) {
+                std::cout << "\n\nAddress: " << access.address << " (store)\n";
+                std::cout << "Store buffered (Access time: " << time << "ms)\n";
+            }
+        }
+        else if (access.type == LOAD && storeBuffers.forward(access.core, access.address)) {
+            time = storeBuffers.accessTime();
+            storeBuffers.advance(access.core, time);
+            if (verbose) {
+                std::cout << "\n\nAddress: " << access.address << std::endl;
+                std::cout << "Forwarded from store buffer (Access time: " << time << "ms)\n";
+            }
+        }
+        else {
+            time = walk(access.address, access.core, access.type);
+            storeBuffers.advance(access.core, time);
+        }
+        analyzer.logLatency(time);
+        return time;
+    }
+
+    void run(const std::vector<MemoryAccess>& accesses) {
+        for (size_t i = 0; i < accesses.size(); ++i) {
+            simulateAccess(accesses[i]);
+        }
+        storeBuffers.drain(writer);
+    }
+
+    void setVerbose(bool on) { verbose = on; }
+
+    double averageAccessTime() const { return analyzer.averageLatency(); }
+    double globalMissRatio(int level) const { return analyzer.globalMissRatio(level); }
+    AnalyzerTotals totals() const { return analyzer.totals(); }
+
+    void statistics(RunStatistics& out) const {
+        analyzer.statistics(out);
+        numa.statistics(out);
+        tiers.statistics(out);
+        cxl.statistics(out);
+        storeBuffers.statistics(out);
+        workingSet.statistics(out);
+        if (backing) {
+            backing->statistics(out);
+        }
+        levels.levelStatistics(out);
+    }
+
+    void report() const {
+        analyzer.report();
+        numa.report();
+        tiers.report();
+        cxl.report();
+        storeBuffers.report();
+        workingSet.report();
+        if (backing) {
+            backing->report();
+        }
+        levels.reportLevels();
+    }
+};
+
+typedef BasicMemoryHierarchy<RuntimeLevels> MemoryHierarchy;
+
+// Automatic configuration tuner
+//
+// Samples cache configurations around a base configuration (size, block
+// size below L1, associativity and policy of every cache level), drops those
+// over the cost budget and evaluates the rest in parallel with successive
+// halving: each rung runs the survivors on a prefix of the workload twice as
+// long as the last, and keeps the best Pareto layers of average access time
+// against cost until at least half the candidates (and the whole front) are
+// kept. The last rung runs the full workload. The L1 block size is left
+// alone as it also sets the TLB page size.
+
+struct TunerConfig {
+    int candidates;
+    double budget;                   // Maximum cost, 0 = unlimited
+    std::vector<double> costPerKB;   // Per cache level
+    int threads;                     // 0 = one per hardware thread
+    unsigned long long seed;         // Sampling and simulation seed, 0 = from the clock
+};
+
+struct TunedPoint {
+    HierarchyConfig config;
+    double cost;
+    double latency;
+};
+
+// Relative cost of the cache levels: capacity in KB times the level's cost
+// per KB, plus 5% per doubling of associativity for the wider tag match
+double configurationCost(const HierarchyConfig& config, const std::vector<double>& costPerKB) {
+    double cost = 0;
+    for (size_t i = 0; i < config.caches.size() && i < costPerKB.size(); ++i) {
+        const LevelConfig& level = config.caches[i];
+        int blocks = std::max(1, level.size / std::max(1, level.blockSize));
+        double tagFactor = 1 + 0.05 * std::log2(static_cast<double>(resolveWays(blocks, level.ways)));
+        cost += level.size / 1024.0 * costPerKB[i] * tagFactor;
+    }
+    return cost;
+}
+
+std::string describeCaches(const HierarchyConfig& config) {
+    static const char* names[] = { "FIFO", "LRU", "Random", "Plugin", "SHiP", "Hawkeye" };
+    std::ostringstream out;
+    for (size_t i = 0; i < config.caches.size(); ++i) {
+        const LevelConfig& level = config.caches[i];
+        out << (i > 0 ? "  " : "") << "L" << i + 1 << " " << level.size << "B/" << level.blockSize << "B/"
+            << (level.ways <= 0 ? std::string("full") : std::to_string(level.ways) + "-way") << "/"
+            << names[level.policy];
+    }
+    return out.str();
+}
+
+// The base configuration first, then distinct random neighbours
+std::vector<HierarchyConfig> sampleConfigurations(const HierarchyConfig& base, int count, unsigned long long seed) {
+    static const double sizeFactors[] = { 0.25, 0.5, 1, 2, 4 };
+    static const int blockFactors[] = { -1, 0, 1 };  // Halve, keep, double
+    static const int associativities[] = { 1, 2, 4, 8, 16 };
+    static const ReplacementPolicy policies[] = { FIFO, LRU, RANDOM, SHIP, HAWKEYE };
+    std::mt19937 rng(static_cast<unsigned int>(seed));
+    std::vector<HierarchyConfig> configs(1, base);
+    std::unordered_map<std::string, bool> seen;
+    seen[describeCaches(base)] = true;
+    for (int attempt = 0; attempt < count * 20 && static_cast<int>(configs.size()) < count; ++attempt) {
+        HierarchyConfig config = base;
+        for (size_t i = 0; i < config.caches.size(); ++i) {
+            LevelConfig& level = config.caches[i];
+            if (i > 0) {
+                int shift = blockFactors[rng() % 3];
+                level.blockSize = std::max(4, shift < 0 ? level.blockSize / 2 : level.blockSize << shift);
+            }
+            level.size = std::max(level.blockSize, static_cast<int>(level.size * sizeFactors[rng() % 5]));
+            level.ways = associativities[rng() % 5];
+            level.policy = policies[rng() % 5];
+        }
+        std::string key = describeCaches(config);
+        if (!seen[key]) {
+            seen[key] = true;
+            configs.push_back(config);
+        }
+    }
+    return configs;
+}
+
+// Runs every point on accesses[0, length) and records its average access time
+// Point i's hierarchy seeds its generators from (seed, i)
+void evaluatePoints(std::vector<TunedPoint>& points, const std::vector<MemoryAccess>& accesses, size_t length,
+    int threads, unsigned long long seed) {
+    std::vector<MemoryAccess> prefix(accesses.begin(), accesses.begin() + length);
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&]() {
+            for (size_t i = next++; i < points.size(); i = next++) {
+                SeedSequence& seeds = seedSequence();
+                seeds.base = counterRandom(seed, i) | 1;
+                seeds.drawn = 0;
+                MemoryHierarchy hierarchy(points[i].config);
+                hierarchy.setVerbose(false);
+                hierarchy.run(prefix);
+                points[i].latency = hierarchy.averageAccessTime();
+            }
+        });
+    }
+    for (size_t t = 0; t < workers.size(); ++t) {
+        workers[t].join();
+    }
+}
+
+bool dominates(const TunedPoint& a, const TunedPoint& b) {
+    return a.cost <= b.cost && a.latency <= b.latency && (a.cost < b.cost || a.latency < b.latency);
+}
+
+// Pareto layer of each point: 0 for the front, 1 for the front of the rest, ...
+std::vector<int> paretoLayers(const std::vector<TunedPoint>& points) {
+    std::vector<int> layer(points.size(), -1);
+    size_t assigned = 0;
+    for (int current = 0; assigned < points.size(); ++current) {
+        std::vector<size_t> members;
+        for (size_t i = 0; i < points.size(); ++i) {
+            if (layer[i] != -1) {
+                continue;
+            }
+            bool dominated = false;
+            for (size_t j = 0; j < points.size() && !dominated; ++j) {
+                dominated = j != i && layer[j] == -1 && dominates(points[j], points[i]);
+            }
+            if (!dominated) {
+                members.push_back(i);
+            }
+        }
+        for (size_t k = 0; k < members.size(); ++k) {
+            layer[members[k]] = current;
+        }
+        assigned += members.size();
+    }
+    return layer;
+}
+
+// Returns the Pareto front of the full-workload rung, cheapest first
+std::vector<TunedPoint> autoTune(const HierarchyConfig& base, const std::vector<MemoryAccess>& accesses,
+    const TunerConfig& tuner) {
+    std::vector<TunedPoint> points;
+    unsigned long long seed = tuner.seed != 0 ? tuner.seed : static_cast<unsigned long long>(std::time(nullptr));
+    std::vector<HierarchyConfig> configs = sampleConfigurations(base, std::max(1, tuner.candidates), seed);
+    for (size_t i = 0; i < configs.size(); ++i) {
+        configs[i].workingSetWindow = 0;  // Only the average access time is read
+        TunedPoint point = { configs[i], configurationCost(configs[i], tuner.costPerKB), 0.0 };
+        if (tuner.budget <= 0 || point.cost <= tuner.budget) {
+            points.push_back(point);
+        }
+    }
+    std::cout << "Tuner: " << configs.size() << " configurations sampled, " << points.size()
+        << " within budget\n";
+    if (points.empty() || accesses.empty()) {
+        return points;
+    }
+
+    int threads = tuner.threads > 0 ? tuner.threads : std::max(1u, std::thread::hardware_concurrency());
+    size_t length = accesses.size();
+    int rungs = 1;
+    while (rungs < 4 && (points.size() >> rungs) > 1 && (length >> rungs) >= 1000) {
+        rungs++;
+    }
+    for (int rung = rungs - 1; rung >= 0; --rung) {
+        size_t prefix = length >> rung;
+        evaluatePoints(points, accesses, prefix, threads, counterRandom(seed, rung));
+        std::cout << "Tuner: evaluated " << points.size() << " configurations on " << prefix << " accesses\n";
+
+        std::vector<int> layer = paretoLayers(points);
+        std::vector<size_t> order(points.size());
+        for (size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return layer[a] != layer[b] ? layer[a] < layer[b] : points[a].latency < points[b].latency;
+        });
+        size_t keep = rung == 0 ? 0 : std::max<size_t>(1, points.size() / 2);
+        std::vector<TunedPoint> survivors;
+        for (size_t k = 0; k < order.size(); ++k) {
+            if (k < keep || layer[order[k]] == 0) {
+                survivors.push_back(points[order[k]]);
+            }
+        }
+        points.swap(survivors);
+    }
+    std::sort(points.begin(), points.end(), [](const TunedPoint& a, const TunedPoint& b) { return a.cost < b.cost; });
+    return points;
+}
+
+void reportParetoFront(const std::vector<TunedPoint>& front) {
+    std::cout << "\nPareto Front (average access time vs cost):\n";
+    for (size_t i = 0; i < front.size(); ++i) {
+        std::cout << "Cost " << std::fixed << std::setprecision(2) << std::setw(10) << front[i].cost
+            << "  Time " << std::setw(8) << front[i].latency << "ms  " << describeCaches(front[i].config) << "\n";
+    }
+}
+
+// Analytical miss-ratio estimation
+//
+// A ReuseSampler watches a sparse random sample of accesses and records the
+// reuse distance (accesses up to the next touch of the same block) of each.
+// From that histogram StatStack turns every reuse distance into an expected
+// stack distance, giving the miss ratio of a fully associative LRU cache of
+// any size. StatCache solves for the miss ratio m of a random-replacement
+// cache of L blocks, where a reuse after d accesses misses with probability
+// 1 - (1 - 1/L)^((d - 1) * m). Samples still watched at the end are cold misses.
+
+class ReuseSampler {
+private:
+    int blockSize;
+    std::mt19937 rng;
+    std::geometric_distribution<long long> gap;
+    long long time;
+    long long nextSample;
+    std::unordered_map<long long, long long> watched;  // Block -> time it was sampled
+    std::map<long long, long long> distances;          // Reuse distance -> samples
+    long long cold;
+    long long total;
+    std::vector<std::pair<double, long long> > stackDistances;  // Expected stack distance -> samples
+
+public:
+    ReuseSampler(int blockSize, int samplePeriod, unsigned int seed)
+        : blockSize(std::max(1, blockSize)), rng(seed), gap(1.0 / std::max(1, samplePeriod)), time(0),
+          nextSample(gap(rng)), cold(0), total(0) {}
+
+    void observe(int address) {
+        long long block = address / blockSize;
+        std::unordered_map<long long, long long>::iterator it = watched.find(block);
+        if (it != watched.end()) {
+            distances[time - it->second]++;
+            total++;
+            watched.erase(it);
+        }
+        if (time == nextSample) {
+            watched[block] = time;
+            nextSample += 1 + gap(rng);
+        }
+        time++;
+    }
+
+    // Closes the pass: unreused samples become cold misses
+    void finish() {
+        cold += watched.size();
+        total += watched.size();
+        watched.clear();
+
+        // sd(d) = sum over k in [1, d) of P(D >= k)
+        stackDistances.clear();
+        double sum = 0;  // Sum of P(D >= k) for k in [1, previous]
+        long long previous = 0;
+        long long atLeast = total;
+        for (std::map<long long, long long>::const_iterator it = distances.begin(); it != distances.end(); ++it) {
+            double share = static_cast<double>(atLeast) / total;
+            stackDistances.push_back(std::make_pair(sum + (it->first - 1 - previous) * share, it->second));
+            sum += (it->first - previous) * share;
+            atLeast -= it->second;
+            previous = it->first;
+        }
+    }
+
+    long long samples() const { return total; }
+
+    // StatStack: fully associative LRU
+    double lruMissRatio(long long cacheBlocks) const {
+        if (total == 0) {
+            return 0.0;
+        }
+        long long misses = cold;
+        for (size_t i = 0; i < stackDistances.size(); ++i) {
+            if (stackDistances[i].first >= cacheBlocks) {
+                misses += stackDistances[i].second;
+            }
+        }
+        return static_cast<double>(misses) / total;
+    }
+
+    // StatCache: random replacement, solved for m by bisection
+    double randomMissRatio(long long cacheBlocks) const {
+        if (total == 0) {
+            return 0.0;
+        }
+        double keep = 1.0 - 1.0 / std::max(1LL, cacheBlocks);
+        double low = 0, high = 1;
+        for (int iteration = 0; iteration < 50; ++iteration) {
+            double m = (low + high) / 2;
+            double misses = cold;
+            for (std::map<long long, long long>::const_iterator it = distances.begin(); it != distances.end(); ++it) {
+                misses += it->second * (1 - std::pow(keep, (it->first - 1) * m));
+            }
+            if (misses / total > m) {
+                low = m;
+            }
+            else {
+                high = m;
+            }
+        }
+        return (low + high) / 2;
+    }
+
+    // Half-width of the 95% confidence interval of a ratio over the samples
+    double confidence(double ratio) const {
+        return total == 0 ? 1.0 : 1.96 * std::sqrt(ratio * (1 - ratio) / total);
+    }
+};
+
+// Estimates every cache level's global miss ratio from one sampled pass;
+// with validate, also runs the full simulation and reports the estimation error
+void estimateMissRatios(const HierarchyConfig& config, const std::vector<MemoryAccess>& accesses, int samplePeriod,
+    bool validate) {
+    static const double sizeFactors[] = { 0.25, 0.5, 1, 2, 4 };
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<ReuseSampler> samplers;
+    for (size_t i = 0; i < config.caches.size(); ++i) {
+        samplers.push_back(ReuseSampler(config.caches[i].blockSize, samplePeriod, 12345 + static_cast<unsigned int>(i)));
+    }
+    for (size_t a = 0; a < accesses.size(); ++a) {
+        for (size_t i = 0; i < samplers.size(); ++i) {
+            // A split L1 only sees data accesses
+            if (i > 0 || !config.splitL1 || accesses[a].type != FETCH) {
+                samplers[i].observe(accesses[a].address);
+            }
+        }
+    }
+    for (size_t i = 0; i < samplers.size(); ++i) {
+        samplers[i].finish();
+    }
+    double estimateTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "\nEstimated Miss Ratio Curves (1 in " << samplePeriod
+        << " accesses sampled, fully associative caches):\n";
+    for (size_t i = 0; i < samplers.size(); ++i) {
+        const LevelConfig& level = config.caches[i];
+        std::cout << "L" << i + 1 << " (" << level.blockSize << "B blocks, " << samplers[i].samples()
+            << " samples):\n";
+        if (samplers[i].samples() == 0) {
+            std::cout << "  No accesses sampled, lower the sampling period\n";
+            continue;
+        }
+        for (int f = 0; f < 5; ++f) {
+            long long blocks = std::max(1LL, static_cast<long long>(level.size * sizeFactors[f]) / level.blockSize);
+            double lru = samplers[i].lruMissRatio(blocks);
+            double random = samplers[i].randomMissRatio(blocks);
+            std::cout << "  " << std::setw(10) << blocks * level.blockSize << "B  LRU " << std::fixed
+                << std::setprecision(2) << lru * 100 << "% +/- " << samplers[i].confidence(lru) * 100
+                << "%  Random " << random * 100 << "% +/- " << samplers[i].confidence(random) * 100 << "%\n";
+        }
+    }
+
+    if (!validate) {
+        std::cout << "Estimation Time: " << std::setprecision(3) << estimateTime * 1000 << "ms\n";
+        return;
+    }
+
+    start = std::chrono::steady_clock::now();
+    MemoryHierarchy hierarchy(config);
+    hierarchy.setVerbose(false);
+    hierarchy.run(accesses);
+    double simulateTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Random-replacement levels are compared with StatCache, LRU levels with
+    // StatStack. Both model fully associative caches; set conflicts, other
+    // policies, bypassing and partitioning fit neither, so their difference
+    // from the estimate is not an estimation error.
+    std::cout << "\nEstimate vs Full Simulation:\n";
+    for (size_t i = 0; i < samplers.size(); ++i) {
+        const LevelConfig& level = config.caches[i];
+        long long blocks = std::max(1, level.size / level.blockSize);
+        bool random = level.policy == RANDOM;
+        bool modeled = (level.policy == LRU || random) && !level.bypassDead
+            && resolveWays(static_cast<int>(blocks), level.ways) == blocks
+            && config.partition.level != static_cast<int>(i) + 1;
+        double estimate = random ? samplers[i].randomMissRatio(blocks) : samplers[i].lruMissRatio(blocks);
+        double simulated = hierarchy.globalMissRatio(static_cast<int>(i) + 1);
+        std::cout << "L" << i + 1 << " Global Miss Ratio: estimated " << std::fixed << std::setprecision(2)
+            << estimate * 100 << "% +/- " << samplers[i].confidence(estimate) * 100 << "% ("
+            << (random ? "StatCache" : "StatStack") << "), simulated " << simulated * 100 << "%, ";
+        if (modeled) {
+            std::cout << "error " << std::fabs(estimate - simulated) * 100 << "%\n";
+        }
+        else {
+            std::cout << "model mismatch\n";
+        }
+    }
+    std::cout << "Estimation Time: " << std::setprecision(3) << estimateTime * 1000 << "ms, Simulation Time: "
+        << simulateTime * 1000 << "ms\n";
+}
+
+// SimPoint-style phase sampling
+//
+// The trace is cut into fixed-length intervals. Each interval's signature is
+// its access frequency per RAM page, normalized and randomly projected down
+// to PHASE_DIMENSIONS values. k-means clusters the signatures for every k up
+// to the maximum (in parallel, several seeds each), and the smallest k whose
+// BIC score reaches 90% of the best range is used. The interval nearest each
+// centroid represents its cluster, weighted by the cluster's share of
+// intervals. Only the representatives are simulated, each after one interval
+// of warm-up, and whole-trace statistics are rebuilt from the weighted deltas.
+const int PHASE_DIMENSIONS = 15;
+const int PHASE_SEEDS = 5;
+
+struct PhaseConfig {
+    int intervalLength;  // Accesses per interval
+    int maxClusters;
+    int threads;         // 0 = one per hardware thread
+    bool compare;        // Also simulate the whole trace
+};
+
+struct Phase {
+    size_t representative;  // Interval index
+    size_t members;
+    double weight;
+};
+
+struct Clustering {
+    std::vector<int> assignment;
+    std::vector<std::vector<double> > centroids;
+    double distortion;  // Sum of squared distances to the centroids
+};
+
+// Projection of one page onto one dimension, uniform in [-1, 1)
+double phaseProjection(long long page, int dimension) {
+    unsigned long long x = static_cast<unsigned long long>(page) * PHASE_DIMENSIONS + dimension;
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return static_cast<double>(x >> 11) / (1ULL << 52) - 1.0;
+}
+
+std::vector<std::vector<double> > intervalSignatures(const std::vector<MemoryAccess>& accesses, int intervalLength,
+    int pageSize) {
+    std::vector<std::vector<double> > signatures;
+    for (size_t start = 0; start < accesses.size(); start += intervalLength) {
+        size_t end = std::min(accesses.size(), start + intervalLength);
+        std::unordered_map<long long, int> counts;
+        for (size_t i = start; i < end; ++i) {
+            counts[accesses[i].address / pageSize]++;
+        }
+        std::vector<double> signature(PHASE_DIMENSIONS, 0.0);
+        for (std::unordered_map<long long, int>::const_iterator it = counts.begin(); it != counts.end(); ++it) {
+            double share = static_cast<double>(it->second) / (end - start);
+            for (int d = 0; d < PHASE_DIMENSIONS; ++d) {
+                signature[d] += share * phaseProjection(it->first, d);
+            }
+        }
+        signatures.push_back(signature);
+    }
+    return signatures;
+}
+
+double squaredDistance(const std::vector<double>& a, const std::vector<double>& b) {
+    double sum = 0;
+    for (size_t d = 0; d < a.size(); ++d) {
+        sum += (a[d] - b[d]) * (a[d] - b[d]);
+    }
+    return sum;
+}
+
+// Lloyd's algorithm from a k-means++ seeding
+Clustering kMeans(const std::vector<std::vector<double> >& points, int k, unsigned int seed) {
+    std::mt19937 rng(seed);
+    Clustering result;
+    result.centroids.push_back(points[rng() % points.size()]);
+    std::vector<double> nearest(points.size());
+    while (static_cast<int>(result.centroids.size()) < k) {
+        double total = 0;
+        for (size_t i = 0; i < points.size(); ++i) {
+            nearest[i] = squaredDistance(points[i], result.centroids[0]);
+            for (size_t c = 1; c < result.centroids.size(); ++c) {
+                nearest[i] = std::min(nearest[i], squaredDistance(points[i], result.centroids[c]));
+            }
+            total += nearest[i];
+        }
+        size_t pick = rng() % points.size();
+        if (total > 0) {
+            double target = std::uniform_real_distribution<double>(0, total)(rng);
+            for (pick = 0; pick + 1 < points.size() && target >= nearest[pick]; ++pick) {
+                target -= nearest[pick];
+            }
+        }
+        result.centroids.push_back(points[pick]);
+    }
+
+    result.assignment.assign(points.size(), -1);
+    for (int iteration = 0; iteration < 100; ++iteration) {
+        bool changed = false;
+        for (size_t i = 0; i < points.size(); ++i) {
+            int best = 0;
+            for (int c = 1; c < k; ++c) {
+                if (squaredDistance(points[i], result.centroids[c]) < squaredDistance(points[i], result.centroids[best])) {
+                    best = c;
+                }
+            }
+            changed = changed || result.assignment[i] != best;
+            result.assignment[i] = best;
+        }
+        if (!changed) {
+            break;
+        }
+        std::vector<std::vector<double> > sums(k, std::vector<double>(PHASE_DIMENSIONS, 0.0));
+        std::vector<int> sizes(k, 0);
+        for (size_t i = 0; i < points.size(); ++i) {
+            sizes[result.assignment[i]]++;
+            for (int d = 0; d < PHASE_DIMENSIONS; ++d) {
+                sums[result.assignment[i]][d] += points[i][d];
+            }
+        }
+        for (int c = 0; c < k; ++c) {
+            for (int d = 0; d < PHASE_DIMENSIONS && sizes[c] > 0; ++d) {
+                result.centroids[c][d] = sums[c][d] / sizes[c];
+            }
+        }
+    }
+    result.distortion = 0;
+    for (size_t i = 0; i < points.size(); ++i) {
+        result.distortion += squaredDistance(points[i], result.centroids[result.assignment[i]]);
+    }
+    return result;
+}
+
+// Bayesian information criterion of a clustering under identical spherical Gaussians
+double clusteringScore(const Clustering& clustering, size_t n) {
+    int k = static_cast<int>(clustering.centroids.size());
+    double d = PHASE_DIMENSIONS;
+    double variance = std::max(1e-12, clustering.distortion / (d * std::max<double>(1, n - k)));
+    std::vector<int> sizes(k, 0);
+    for (size_t i = 0; i < clustering.assignment.size(); ++i) {
+        sizes[clustering.assignment[i]]++;
+    }
+    double likelihood = 0;
+    for (int c = 0; c < k; ++c) {
+        if (sizes[c] > 0) {
+            likelihood += sizes[c] * std::log(static_cast<double>(sizes[c]) / n)
+                - sizes[c] * d / 2 * std::log(2 * std::acos(-1.0) * variance);
+        }
+    }
+    likelihood -= d * (static_cast<double>(n) - k) / 2;
+    return likelihood - k * (d + 1) / 2 * std::log(static_cast<double>(n));
+}
+
+std::vector<Phase> selectPhases(const std::vector<std::vector<double> >& signatures, const PhaseConfig& phases) {
+    int maxK = std::max(1, std::min(phases.maxClusters, static_cast<int>(signatures.size())));
+    std::vector<Clustering> runs(maxK * PHASE_SEEDS);
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> workers;
+    int threads = phases.threads > 0 ? phases.threads : std::max(1u, std::thread::hardware_concurrency());
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&]() {
+            for (size_t i = next++; i < runs.size(); i = next++) {
+                runs[i] = kMeans(signatures, static_cast<int>(i / PHASE_SEEDS) + 1, static_cast<unsigned int>(i));
+            }
+        });
+    }
+    for (size_t t = 0; t < workers.size(); ++t) {
+        workers[t].join();
+    }
+
+    // Best seed per k, then the smallest k scoring within 90% of the range
+    std::vector<size_t> best(maxK);
+    std::vector<double> scores(maxK);
+    for (int k = 0; k < maxK; ++k) {
+        best[k] = k * PHASE_SEEDS;
+        for (int s = 1; s < PHASE_SEEDS; ++s) {
+            if (runs[k * PHASE_SEEDS + s].distortion < runs[best[k]].distortion) {
+                best[k] = k * PHASE_SEEDS + s;
+            }
+        }
+        scores[k] = clusteringScore(runs[best[k]], signatures.size());
+    }
+    double low = *std::min_element(scores.begin(), scores.end());
+    double high = *std::max_element(scores.begin(), scores.end());
+    int chosen = 0;
+    while (chosen + 1 < maxK && scores[chosen] < low + 0.9 * (high - low)) {
+        chosen++;
+    }
+
+    const Clustering& clustering = runs[best[chosen]];
+    std::vector<Phase> result;
+    for (int c = 0; c <= chosen; ++c) {
+        Phase phase = { 0, 0, 0.0 };
+        double closest = -1;
+        for (size_t i = 0; i < signatures.size(); ++i) {
+            if (clustering.assignment[i] != c) {
+                continue;
+            }
+            phase.members++;
+            double distance = squaredDistance(signatures[i], clustering.centroids[c]);
+            if (closest < 0 || distance < closest) {
+                closest = distance;
+                phase.representative = i;
+            }
+        }
+        if (phase.members > 0) {
+            phase.weight = static_cast<double>(phase.members) / signatures.size();
+            result.push_back(phase);
+        }
+    }
+    return result;
+}
+
+void reportReconstruction(const std::string& title, const AnalyzerTotals& totals, const PerformanceAnalyzer& names) {
+    std::cout << title << " Average Access Time: " << std::fixed << std::setprecision(2)
+        << (totals.requests > 0 ? totals.latency / totals.requests : 0.0) << "ms\n";
+    for (size_t level = 0; level < totals.hits.size(); ++level) {
+        if (level + 3 == totals.hits.size()) {
+            continue;  // Disk accesses are not lookups
+        }
+        double lookups = totals.hits[level] + totals.misses[level];
+        if (lookups > 0) {
+            std::cout << title << " " << names.levelName(static_cast<int>(level)) << " Hit Rate: "
+                << totals.hits[level] / lookups * 100 << "%\n";
+        }
+    }
+}
+
+// Simulates the representative intervals and scales their weighted
+// statistics up to the whole trace
+void simulatePhases(const HierarchyConfig& config, const std::vector<MemoryAccess>& accesses,
+    const PhaseConfig& phases) {
+    if (accesses.empty()) {
+        return;
+    }
+    size_t length = std::max(1, phases.intervalLength);
+    std::vector<std::vector<double> > signatures =
+        intervalSignatures(accesses, static_cast<int>(length), std::max(1, config.ram.blockSize));
+    std::vector<Phase> selected = selectPhases(signatures, phases);
+
+    // Each representative runs in its own hierarchy, warmed by the interval before it
+    std::vector<AnalyzerTotals> deltas(selected.size());
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> workers;
+    int threads = phases.threads > 0 ? phases.threads : std::max(1u, std::thread::hardware_concurrency());
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&]() {
+            for (size_t p = next++; p < selected.size(); p = next++) {
+                size_t start = selected[p].representative * length;
+                size_t end = std::min(accesses.size(), start + length);
+                MemoryHierarchy hierarchy(config);
+                hierarchy.setVerbose(false);
+                hierarchy.run(std::vector<MemoryAccess>(accesses.begin() + (start >= length ? start - length : 0),
+                    accesses.begin() + start));
+                AnalyzerTotals warm = hierarchy.totals();
+                hierarchy.run(std::vector<MemoryAccess>(accesses.begin() + start, accesses.begin() + end));
+                deltas[p] = hierarchy.totals();
+                deltas[p].subtract(warm);
+            }
+        });
+    }
+    for (size_t t = 0; t < workers.size(); ++t) {
+        workers[t].join();
+    }
+
+    // Per-access rates of each representative, weighted by its phase's share of the trace
+    AnalyzerTotals rebuilt = deltas[0];
+    rebuilt.scale(0);
+    size_t simulated = 0;
+    std::cout << "\nPhases: " << selected.size() << " clusters over " << signatures.size() << " intervals of "
+        << length << " accesses\n";
+    for (size_t p = 0; p < selected.size(); ++p) {
+        std::cout << "Phase " << p << ": interval " << selected[p].representative << " represents "
+            << selected[p].members << " intervals (weight " << std::fixed << std::setprecision(2)
+            << selected[p].weight * 100 << "%)\n";
+        simulated += static_cast<size_t>(deltas[p].requests);
+        AnalyzerTotals share = deltas[p];
+        share.scale(deltas[p].requests > 0 ? selected[p].weight * accesses.size() / deltas[p].requests : 0.0);
+        rebuilt.add(share);
+    }
+    std::cout << "Simulated " << simulated << " of " << accesses.size() << " accesses ("
+        << 100.0 * simulated / accesses.size() << "%)\n";
+    PerformanceAnalyzer names(static_cast<int>(config.caches.size()), config.splitL1);
+    reportReconstruction("Reconstructed", rebuilt, names);
+
+    if (phases.compare) {
+        MemoryHierarchy full(config);
+        full.setVerbose(false);
+        full.run(accesses);
+        AnalyzerTotals exact = full.totals();
+        reportReconstruction("Full Trace", exact, names);
+        double estimate = rebuilt.requests > 0 ? rebuilt.latency / rebuilt.requests : 0.0;
+        double actual = exact.requests > 0 ? exact.latency / exact.requests : 0.0;
+        std::cout << "Average Access Time Error: " << std::fabs(estimate - actual) / std::max(1e-9, actual) * 100
+            << "%\n";
+    }
+}
+
+// Monte Carlo replicas
+//
+// Runs independently seeded copies of the hierarchy on the same accesses,
+// one per thread at a time, and summarizes their end-of-run statistics:
+// each is printed as its mean across replicas and, where replicas disagree,
+// the half-width of its 95% confidence interval.
+
+// Two-sided 95% Student t critical value
+double studentT95(int degrees) {
+    static const double table[] = { 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042 };
+    return degrees >= 1 && degrees <= 30 ? table[degrees - 1] : 1.96;
+}
+
+std::string captureReport(const SimulatorInstance& simulator) {
+    std::ostringstream captured;
+    std::streambuf* previous = std::cout.rdbuf(captured.rdbuf());
+    simulator.report();
+    std::cout.rdbuf(previous);
+    return captured.str();
+}
+
+void summarizeReplicas(const std::vector<RunStatistics>& runs) {
+    size_t n = runs.size();
+    const RunStatistics& first = runs[0];
+    for (size_t k = 0; k < first.names.size(); ++k) {
+        double mean = 0, variance = 0;
+        bool same = true;
+        for (size_t r = 0; r < n; ++r) {
+            mean += runs[r].values[k] / n;
+            same = same && runs[r].values[k] == first.values[k];
+        }
+        for (size_t r = 0; r < n; ++r) {
+            variance += (runs[r].values[k] - mean) * (runs[r].values[k] - mean) / (n - 1);
+        }
+        std::cout << first.names[k] << ": " << std::fixed << std::setprecision(2) << (same ? first.values[k] : mean);
+        if (!same) {
+            std::cout << " +/- " << studentT95(static_cast<int>(n) - 1) * std::sqrt(variance / n);
+        }
+        std::cout << "\n";
+    }
+}
+
+// Runs the replicas in parallel; replica r seeds its generators from (seed, r)
+void runReplicas(const HierarchyConfig& config, const std::vector<MemoryAccess>& accesses, int replicas,
+    unsigned long long seed) {
+    if (seed == 0) {
+        seed = static_cast<unsigned long long>(std::time(nullptr));
+    }
+    // Each worker keeps only the statistics, so at most one hierarchy per
+    // thread is alive at a time
+    std::vector<RunStatistics> runs(replicas);
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> workers;
+    int threads = std::min<int>(replicas, std::max(1u, std::thread::hardware_concurrency()));
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&]() {
+            for (size_t r = next++; r < runs.size(); r = next++) {
+                SeedSequence& seeds = seedSequence();
+                seeds.base = counterRandom(seed, r) | 1;
+                seeds.drawn = 0;
+                MemoryHierarchy hierarchy(config);
+                hierarchy.setVerbose(false);
+                hierarchy.run(accesses);
+                hierarchy.statistics(runs[r]);
+            }
+        });
+    }
+    for (size_t t = 0; t < workers.size(); ++t) {
+        workers[t].join();
+    }
+
+    std::cout << "\nMean of " << replicas << " replicas (+/- 95% confidence interval):\n";
+    summarizeReplicas(runs);
+}
+
+// Follow mode
+//
+// Tails a trace file that another process keeps appending to, like tail -f:
+// new complete lines are parsed and simulated as they arrive, a line still
+// being written is held back until its newline shows up, and a file that
+// shrinks (truncated) or is replaced by a new file at the same path (rotated,
+// detected by its device and inode) is read again from the start. Every
+// window of accesses prints one line of statistics for that window alone.
+// Following stops at the idle timeout or on Ctrl-C, then prints the report.
+
+struct FollowConfig {
+    long long windowLength;  // Accesses per statistics window
+    int pollInterval;        // ms between checks for new records
+    int idleTimeout;         // Seconds without new records before stopping, 0 = never
+};
+
+volatile std::sig_atomic_t followInterrupted = 0;
+
+void interruptFollow(int) {
+    followInterrupted = 1;
+}
+
+void reportWindow(long long window, const AnalyzerTotals& delta, const PerformanceAnalyzer& names) {
+    std::cout << "Window " << window << ": " << static_cast<long long>(delta.requests) << " accesses, "
+        << std::fixed << std::setprecision(2) << (delta.requests > 0 ? delta.latency / delta.requests : 0.0)
+        << "ms average";
+    for (size_t level = 0; level < delta.hits.size(); ++level) {
+        double lookups = delta.hits[level] + delta.misses[level];
+        if (level + 3 != delta.hits.size() && lookups > 0) {  // Disk accesses are not lookups
+            std::cout << ", " << names.levelName(static_cast<int>(level)) << " " << delta.hits[level] / lookups * 100
+                << "%";
+        }
+    }
+    std::cout << std::endl;
+}
+
+void followTrace(const HierarchyConfig& config, const std::string& path, int numCores, const FollowConfig& follow) {
+    std::ifstream in(path.c_str());
+    struct stat opened;
+    if (!in || stat(path.c_str(), &opened) != 0) {
+        std::cerr << "Cannot open trace file " << path << "\n";
+        return;
+    }
+    MemoryHierarchy hierarchy(config);
+    hierarchy.setVerbose(false);
+    PerformanceAnalyzer names(static_cast<int>(config.caches.size()), config.splitL1);
+    TraceParser parser(numCores);
+    AnalyzerTotals windowStart = hierarchy.totals();
+    long long window = 0;
+    long long inWindow = 0;
+    std::string partial;
+    std::vector<MemoryAccess> accesses;
+    std::chrono::steady_clock::time_point lastRecord = std::chrono::steady_clock::now();
+    std::cout << "Following " << path << " (windows of " << follow.windowLength << " accesses, Ctrl-C stops)"
+        << std::endl;
+    followInterrupted = 0;
+    void (*previousHandler)(int) = std::signal(SIGINT, interruptFollow);
+
+    while (!followInterrupted) {
+        std::string line;
+        if (std::getline(in, line)) {
+            if (in.eof()) {
+                partial += line;  // No newline yet: the writer is mid-line
+                continue;
+            }
+            accesses.clear();
+            parser.parse(partial + line, accesses);
+            partial.clear();
+            for (size_t i = 0; i < accesses.size(); ++i) {
+                hierarchy.simulateAccess(accesses[i]);
+                if (++inWindow == follow.windowLength) {
+                    AnalyzerTotals now = hierarchy.totals();
+                    AnalyzerTotals delta = now;
+                    delta.subtract(windowStart);
+                    reportWindow(window++, delta, names);
+                    windowStart = now;
+                    inWindow = 0;
+                }
+            }
+            lastRecord = std::chrono::steady_clock::now();
+            continue;
+        }
+
+        // At the end of the file: wait for more, or start over if it was
+        // replaced or shrank. While a rotated file is missing, keep waiting.
+        in.clear();
+        std::streampos position = in.tellg();
+        struct stat info;
+        if (stat(path.c_str(), &info) == 0) {
+            bool rotated = info.st_dev != opened.st_dev || info.st_ino != opened.st_ino;
+            if (rotated || (position != std::streampos(-1) && info.st_size < position)) {
+                std::cout << path << (rotated ? " was replaced" : " was truncated") << ", reading it from the start"
+                    << std::endl;
+                in.close();
+                in.open(path.c_str());
+                opened = info;
+                partial.clear();
+                continue;
+            }
+        }
+        double idle = std::chrono::duration<double>(std::chrono::steady_clock::now() - lastRecord).count();
+        if (follow.idleTimeout > 0 && idle >= follow.idleTimeout) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(std::max(1, follow.pollInterval)));
+    }
+
+    if (inWindow > 0) {
+        AnalyzerTotals delta = hierarchy.totals();
+        delta.subtract(windowStart);
+        reportWindow(window, delta, names);
+    }
+    std::signal(SIGINT, previousHandler);
+    parser.warn(path);
+    if (followInterrupted) {
+        std::cout << "Interrupted, stopping.\n";
+    }
+    else {
+        std::cout << "No new records for " << follow.idleTimeout << "s, stopping.\n";
+    }
+    hierarchy.run(std::vector<MemoryAccess>());  // Drains the store buffers
+    hierarchy.report();
+}
+
+// Simulation server
+//
+// Keeps hierarchies resident and serves requests over a Unix domain socket,
+// one client connection at a time, so tools that issue many small queries
+// skip process start-up and hierarchy construction. Instance 0 is the
+// configured hierarchy; clients create more by overriding cache levels. A
+// client that sends nothing for SERVER_IDLE_SECONDS is disconnected so it
+// cannot hold the server. The socket path is only replaced if it is a stale
+// socket; any other file there is left alone.
+//
+// All integers are little-endian. A request is a 12-byte header
+//   u8 opcode, u8[3] zero, u32 instance, u32 count
+// followed by count payload records. A response is
+//   i32 status (0 = ok, 1 = error), u32 body length, body
+// where an error's body is its message.
+//
+//   1 ACCESS    records of u32 address (below 2^31), u16 core, u8 type
+//               (0 load, 1 store, 2 fetch), u8 zero, u32 pc. A batch with an
+//               invalid record is rejected whole. Body: f64 total latency (ms),
+//               u32 levels, then u64 hits and u64 misses for this batch per
+//               analyzer level (TLB, caches, RAM, disk, iTLB, L1I)
+//   2 CREATE    copies the instance's configuration with cache level
+//               overrides: records of u32 level (1 = L1), u32 size,
+//               u32 block size, i32 ways, u32 policy. Body: u32 new instance
+//   3 RESET     rebuilds the instance from its configuration, clearing state
+//   4 DESTROY   frees the instance (instance 0 cannot be destroyed)
+//   5 REPORT    body: the instance's performance report as text; leaves the
+//               instance's state untouched
+//   6 SHUTDOWN  stops the server
+enum ServerOpcode {
+    SERVER_ACCESS = 1,
+    SERVER_CREATE = 2,
+    SERVER_RESET = 3,
+    SERVER_DESTROY = 4,
+    SERVER_REPORT = 5,
+    SERVER_SHUTDOWN = 6
+};
+
+const size_t SERVER_HEADER_BYTES = 12;
+const size_t SERVER_ACCESS_BYTES = 12;
+const size_t SERVER_CREATE_BYTES = 20;
+const unsigned int SERVER_MAX_RECORDS = 1 << 16;  // Bounds a request's buffers to about 1 MB
+const int SERVER_IDLE_SECONDS = 30;
+
+class SimulationServer {
+private:
+    std::vector<HierarchyConfig> configs;
+    std::vector<std::unique_ptr<MemoryHierarchy> > instances;  // Null once destroyed
+    bool stopping;
+
+    static unsigned int readU32(const unsigned char* p) {
+        return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<unsigned int>(p[3]) << 24);
+    }
+
+    static void appendU32(std::string& out, unsigned int value) {
+        for (int i = 0; i < 4; ++i) {
+            out += static_cast<char>((value >> (8 * i)) & 0xFF);
+        }
+    }
+
+    static void appendU64(std::string& out, unsigned long long value) {
+        for (int i = 0; i < 8; ++i) {
+            out += static_cast<char>((value >> (8 * i)) & 0xFF);
+        }
+    }
+
+    static void appendF64(std::string& out, double value) {
+        unsigned long long bits;
+        std::memcpy(&bits, &value, sizeof bits);
+        appendU64(out, bits);
+    }
+
+    static bool readFully(int fd, unsigned char* buffer, size_t length) {
+        while (length > 0) {
+            ssize_t got = read(fd, buffer, length);
+            if (got <= 0) {
+                return false;
+            }
+            buffer += got;
+            length -= static_cast<size_t>(got);
+        }
+        return true;
+    }
+
+    static bool writeFully(int fd, const std::string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t put = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (put <= 0) {
+                return false;
+            }
+            sent += static_cast<size_t>(put);
+        }
+        return true;
+    }
+
+    static bool respond(int fd, int status, const std::string& body) {
+        std::string out;
+        appendU32(out, static_cast<unsigned int>(status));
+        appendU32(out, static_cast<unsigned int>(body.size()));
+        return writeFully(fd, out + body);
+    }
+
+    // Runs one batch; returns false with a message if a record is invalid
+    bool access(MemoryHierarchy& hierarchy, int cores, const std::vector<unsigned char>& payload,
+        unsigned int count, std::string& body) {
+        std::vector<MemoryAccess> accesses(count);
+        for (unsigned int i = 0; i < count; ++i) {
+            const unsigned char* record = &payload[i * SERVER_ACCESS_BYTES];
+            unsigned int address = readU32(record);
+            if (address > static_cast<unsigned int>(INT_MAX)) {
+                body = "Access " + std::to_string(i) + " has address " + std::to_string(address)
+                    + ", outside the 31-bit address space";
+                return false;
+            }
+            accesses[i].address = static_cast<int>(address);
+            accesses[i].core = record[4] | (record[5] << 8);
+            if (accesses[i].core >= cores) {
+                body = "Access " + std::to_string(i) + " names core " + std::to_string(accesses[i].core)
+                    + ", but only " + std::to_string(cores) + " are configured";
+                return false;
+            }
+            accesses[i].pc = static_cast<int>(readU32(record + 8));
+            if (record[6] > FETCH) {
+                body = "Access " + std::to_string(i) + " has an unknown type";
+                return false;
+            }
+            accesses[i].type = static_cast<AccessType>(record[6]);
+        }
+        AnalyzerTotals before = hierarchy.totals();
+        for (unsigned int i = 0; i < count; ++i) {
+            hierarchy.simulateAccess(accesses[i]);
+        }
+        AnalyzerTotals delta = hierarchy.totals();
+        delta.subtract(before);
+        appendF64(body, delta.latency);
+        appendU32(body, static_cast<unsigned int>(delta.hits.size()));
+        for (size_t level = 0; level < delta.hits.size(); ++level) {
+            appendU64(body, static_cast<unsigned long long>(delta.hits[level]));
+            appendU64(body, static_cast<unsigned long long>(delta.misses[level]));
+        }
+        return true;
+    }
+
+    bool create(const HierarchyConfig& base, const std::vector<unsigned char>& payload, unsigned int count,
+        std::string& body) {
+        HierarchyConfig config = base;
+        for (unsigned int i = 0; i < count; ++i) {
+            const unsigned char* record = &payload[i * SERVER_CREATE_BYTES];
+            unsigned int level = readU32(record);
+            unsigned int policy = readU32(record + 16);
+            if (level < 1 || level > config.caches.size()) {
+                body = "No cache level " + std::to_string(level);
+                return false;
+            }
+            if (policy > HAWKEYE || policy == PLUGIN) {
+                body = "Policy " + std::to_string(policy) + " cannot be set over the socket";
+                return false;
+            }
+            LevelConfig& cache = config.caches[level - 1];
+            int blockSize = static_cast<int>(readU32(record + 8));
+            cache.size = static_cast<int>(readU32(record + 4));
+            cache.ways = static_cast<int>(readU32(record + 12));
+            cache.policy = static_cast<ReplacementPolicy>(policy);
+            if (blockSize <= 0 || cache.size < blockSize || (level == 1 && blockSize != cache.blockSize)) {
+                body = "Invalid geometry for L" + std::to_string(level) + " (the L1 block size is the TLB page size)";
+                return false;
+            }
+            cache.blockSize = blockSize;
+        }
+        configs.push_back(config);
+        instances.push_back(build(config));
+        appendU32(body, static_cast<unsigned int>(instances.size() - 1));
+        return true;
+    }
+
+    static std::unique_ptr<MemoryHierarchy> build(const HierarchyConfig& config) {
+        std::unique_ptr<MemoryHierarchy> hierarchy(new MemoryHierarchy(config));
+        hierarchy->setVerbose(false);
+        return hierarchy;
+    }
+
+    // Serves one connection until the client closes it or asks to shut down
+    void serveClient(int fd) {
+        unsigned char header[SERVER_HEADER_BYTES];
+        while (!stopping && readFully(fd, header, sizeof header)) {
+            int opcode = header[0];
+            unsigned int id = readU32(header + 4);
+            unsigned int count = readU32(header + 8);
+            size_t recordBytes = opcode == SERVER_ACCESS ? SERVER_ACCESS_BYTES
+                : opcode == SERVER_CREATE ? SERVER_CREATE_BYTES : 0;
+            if (count > SERVER_MAX_RECORDS) {
+                respond(fd, 1, "Batch too large");
+                return;  // The payload cannot be skipped safely
+            }
+            std::vector<unsigned char> payload(count * recordBytes);
+            if (!payload.empty() && !readFully(fd, &payload[0], payload.size())) {
+                return;
+            }
+
+            std::string body;
+            bool ok = true;
+            if (opcode == SERVER_SHUTDOWN) {
+                stopping = true;
+            }
+            else if (id >= instances.size() || !instances[id]) {
+                ok = false;
+                body = "No instance " + std::to_string(id);
+            }
+            else if (opcode == SERVER_ACCESS) {
+                ok = access(*instances[id], configs[id].cores, payload, count, body);
+            }
+            else if (opcode == SERVER_CREATE) {
+                ok = create(configs[id], payload, count, body);
+            }
+            else if (opcode == SERVER_RESET) {
+                instances[id] = build(configs[id]);
+            }
+            else if (opcode == SERVER_DESTROY) {
+                ok = id != 0;
+                if (ok) {
+                    instances[id].reset();
+                }
+                else {
+                    body = "Instance 0 cannot be destroyed";
+                }
+            }
+            else if (opcode == SERVER_REPORT) {
+                body = captureReport(*instances[id]);
+            }
+            else {
+                ok = false;
+                body = "Unknown opcode " + std::to_string(opcode);
+            }
+            if (!respond(fd, ok ? 0 : 1, body)) {
+                return;
+            }
+        }
+    }
+
+public:
+    explicit SimulationServer(const HierarchyConfig& config) : stopping(false) {
+        configs.push_back(config);
+        instances.push_back(build(config));
+    }
+
+    void serve(const std::string& path) {
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof address);
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof address.sun_path) {
+            std::cerr << "Socket path " << path << " is too long\n";
+            return;
+        }
+        std::strcpy(address.sun_path, path.c_str());
+        struct stat existing;
+        if (lstat(path.c_str(), &existing) == 0) {
+            if (!S_ISSOCK(existing.st_mode)) {
+                std::cerr << "Cannot listen on " << path << ": it exists and is not a socket\n";
+                return;
+            }
+            unlink(path.c_str());
+        }
+        int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listener < 0 || bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof address) != 0
+            || listen(listener, 8) != 0) {
+            std::cerr << "Cannot listen on " << path << ": " << std::strerror(errno) << "\n";
+            if (listener >= 0) {
+                close(listener);
+            }
+            return;
+        }
+        std::cout << "Serving on " << path << std::endl;
+        while (!stopping) {
+            int client = accept(listener, nullptr, nullptr);
+            if (client < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                std::cerr << "accept failed: " << std::strerror(errno) << "\n";
+                break;
+            }
+            timeval idle;
+            idle.tv_sec = SERVER_IDLE_SECONDS;
+            idle.tv_usec = 0;
+            setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &idle, sizeof idle);
+            serveClient(client);
+            close(client);
+        }
+        close(listener);
+        unlink(path.c_str());
+        std::cout << "Server stopped\n";
+    }
+};
+
+// Specialized simulators
+//
+// For hot recurring configurations the simulator emits a C++ translation unit
+// that includes this file (with MHS_NO_MAIN defined) and declares every level
+// as a concrete store type with constant geometry, policy and latency. It is
+// compiled with the system compiler ($CXX, default c++) into a shared object
+// under $TMPDIR and loaded with dlopen. Objects are named after a hash of the
+// configuration, the source path and the time this binary was built, so later
+// runs of the same binary reuse them and a rebuilt binary compiles afresh.
+// The fast-miss filter only changes host cost, not results, so it is left out.
+
+std::string policyTypeName(ReplacementPolicy policy) {
+    switch (policy) {
+    case LRU:
+        return "LruPolicy";
+    case RANDOM:
+        return "RandomPolicy";
+    case SHIP:
+        return "ShipPolicy";
+    case HAWKEYE:
+        return "HawkeyePolicy";
+    default:
+        return "FifoPolicy";
+    }
+}
+
+// Mirrors AssociativeLevel's geometry and makeStoreWithPolicy's store choice
+void emitSpecializedStore(std::ostream& out, const std::string& name, int blocks, const LevelConfig& level) {
+    int numBlocks = std::max(1, blocks);
+    int ways = resolveWays(numBlocks, level.ways);
+    int numSets = numBlocks / ways;
+    std::string policy = policyTypeName(storePolicy(numSets, ways, level.policy));
+    if (numSets == 1 && ways > 1) {
+        out << "    HashedAssociativeStore<int, " << policy << "> " << name << "{" << ways << "};\n";
+    }
+    else {
+        out << "    AssociativeStore<int, StaticGeometry<" << numSets << ", " << ways << ">, "
+            << policy << "> " << name << "{" << numSets << ", " << ways << "};\n";
+    }
+}
+
+void generateSpecializedSource(std::ostream& out, const HierarchyConfig& config, const std::string& sourcePath) {
+    const std::vector<LevelConfig>& caches = config.caches;
+    out << "// Generated by memory_simulator. Do not edit.\n";
+    out << "#define MHS_NO_MAIN\n";
+    out << "#include \"" << sourcePath << "\"\n\n";
+    out << "namespace {\n\n";
+    out << "struct SpecializedLevels {\n";
+    for (size_t i = 0; i < caches.size(); ++i) {
+        emitSpecializedStore(out, "l" + std::to_string(i + 1), caches[i].size / caches[i].blockSize, caches[i]);
+    }
+    emitSpecializedStore(out, "ram", config.ram.size / config.ram.blockSize, config.ram);
+    emitSpecializedStore(out, "tlb", config.tlb.size, config.tlb);
+    if (config.splitL1) {
+        emitSpecializedStore(out, "l1i", config.l1i.size / config.l1i.blockSize, config.l1i);
+        emitSpecializedStore(out, "itlb", config.itlb.size, config.itlb);
+    }
+    out << "\n    explicit SpecializedLevels(const HierarchyConfig&) {}\n\n";
+    out << "    int cacheCount() const { return " << caches.size() << "; }\n";
+    out << "    int pageSize() const { return " << std::max(1, caches[0].blockSize) << "; }\n";
+    out << "    bool accessTlb(int page) { return tlb.access(page); }\n";
+    out << "    int tlbAccessTime() const { return " << config.tlb.accessTime << "; }\n";
+    out << "    bool accessCache(int i, int address) {\n";
+    out << "        switch (i) {\n";
+    for (size_t i = 0; i < caches.size(); ++i) {
+        out << "        case " << i << ": return l" << i + 1 << ".access(address / " << caches[i].blockSize << ");\n";
+    }
+    out << "        }\n";
+    out << "        return false;\n";
+    out << "    }\n";
+    out << "    int cacheAccessTime(int i) const {\n";
+    out << "        switch (i) {\n";
+    for (size_t i = 0; i < caches.size(); ++i) {
+        out << "        case " << i << ": return " << caches[i].accessTime << ";\n";
+    }
+    out << "        }\n";
+    out << "        return 0;\n";
+    out << "    }\n";
+    out << "    int evictedPage = -1;\n";
+    out << "    bool accessRam(int address) {\n";
+    out << "        int page = address / " << config.ram.blockSize << ";\n";
+    out << "        if (ram.touch(page)) {\n";
+    out << "            evictedPage = -1;\n";
+    out << "            return true;\n";
+    out << "        }\n";
+    out << "        evictedPage = ram.fill(page);\n";
+    out << "        return false;\n";
+    out << "    }\n";
+    out << "    int ramEvicted() { return evictedPage; }\n";
+    out << "    int ramAccessTime() const { return " << config.ram.accessTime << "; }\n";
+    out << "    int diskAccessTime() const { return " << config.diskAccessTime << "; }\n";
+    out << "    bool splitL1() const { return " << (config.splitL1 ? "true" : "false") << "; }\n";
+    if (config.splitL1) {
+        out << "    bool accessInstructionTlb(int page) { return itlb.access(page); }\n";
+        out << "    int instructionTlbAccessTime() const { return " << config.itlb.accessTime << "; }\n";
+        out << "    bool accessInstructionCache(int address) { return l1i.access(address / " << config.l1i.blockSize
+            << "); }\n";
+        out << "    int instructionCacheAccessTime() const { return " << config.l1i.accessTime << "; }\n";
+    }
+    else {
+        out << "    bool accessInstructionTlb(int) { return false; }\n";
+        out << "    int instructionTlbAccessTime() const { return 0; }\n";
+        out << "    bool accessInstructionCache(int) { return false; }\n";
+        out << "    int instructionCacheAccessTime() const { return 0; }\n";
+    }
+    out << "    void reportLevels() const {}\n";
+    out << "    void levelStatistics(RunStatistics&) const {}\n";
+    out << "};\n\n";
+    out << "}  // namespace\n\n";
+    out << "extern \"C\" SimulatorInstance* mhs_create_specialized(const HierarchyConfig* config) {\n";
+    out << "    return new BasicMemoryHierarchy<SpecializedLevels>(*config);\n";
+    out << "}\n";
+}
+
+// Quotes a path for the shell that std::system runs
+std::string shellQuote(const std::string& text) {
+    std::string quoted = "'";
+    for (size_t i = 0; i < text.size(); ++i) {
+        quoted += text[i] == '\'' ? std::string("'\\''") : std::string(1, text[i]);
+    }
+    return quoted + "'";
+}
+
+// Owned by this user and closed to everyone else, as a directory (0700) or
+// as a file nobody else can write
+bool privatePath(const std::string& path, bool directory) {
+    struct stat info;
+    if (lstat(path.c_str(), &info) != 0 || info.st_uid != geteuid()) {
+        return false;
+    }
+    return directory ? S_ISDIR(info.st_mode) && (info.st_mode & 077) == 0
+        : S_ISREG(info.st_mode) && (info.st_mode & 022) == 0;
+}
+
+// Per-user cache directory for generated simulators:
+// $XDG_CACHE_HOME/memory_simulator, or ~/.cache/memory_simulator. Created
+// 0700; returns an empty path (after explaining why) if it cannot be made or
+// is not private, so nothing is ever loaded from a directory others control.
+std::string specializedCacheDirectory() {
+    const char* xdg = std::getenv("XDG_CACHE_HOME");
+    const char* home = std::getenv("HOME");
+    std::string base;
+    if (xdg && xdg[0] == '/') {
+        base = xdg;
+    }
+    else if (home && home[0] == '/') {
+        base = std::string(home) + "/.cache";
+    }
+    else {
+        std::cerr << "Neither XDG_CACHE_HOME nor HOME is set to an absolute path.\n";
+        return "";
+    }
+    std::string directory = base + "/memory_simulator";
+    if ((mkdir(base.c_str(), 0700) != 0 && errno != EEXIST)
+        || (mkdir(directory.c_str(), 0700) != 0 && errno != EEXIST)) {
+        std::cerr << "Could not create " << directory << ": " << std::strerror(errno) << "\n";
+        return "";
+    }
+    if (!privatePath(directory, true)) {
+        std::cerr << directory << " is not a directory private to this user (mode 0700).\n";
+        return "";
+    }
+    return directory;
+}
+
+std::string describeLevel(const LevelConfig& level) {
+    return std::to_string(level.size) + "/" + std::to_string(level.blockSize) + "/"
+        + std::to_string(level.accessTime) + "/" + std::to_string(level.policy) + "/" + std::to_string(level.ways);
+}
+
+// Builds, or reuses, a specialized simulator for config. Returns null (after
+// explaining why) when the configuration cannot be specialized or the build
+// fails, in which case the caller falls back to MemoryHierarchy.
+std::unique_ptr<SimulatorInstance> loadSpecializedSimulator(const HierarchyConfig& config) {
+    typedef SimulatorInstance* (*CreateFunction)(const HierarchyConfig*);
+    std::unique_ptr<SimulatorInstance> none;
+
+    if (config.ram.policy == PLUGIN || config.tlb.policy == PLUGIN
+        || (config.cxl.enabled && config.cxl.policy == PLUGIN)
+        || (config.splitL1 && (config.l1i.policy == PLUGIN || config.itlb.policy == PLUGIN))) {
+        std::cerr << "Plugin policies cannot be specialized.\n";
+        return none;
+    }
+    for (size_t i = 0; i < config.caches.size(); ++i) {
+        if (config.caches[i].policy == PLUGIN) {
+            std::cerr << "Plugin policies cannot be specialized.\n";
+            return none;
+        }
+    }
+
+    for (size_t i = 1; i < config.caches.size(); ++i) {
+        if (config.caches[i].bypassDead) {
+            std::cerr << "Dead-block bypass cannot be specialized.\n";
+            return none;
+        }
+    }
+    if (config.partition.level > 0) {
+        std::cerr << "Partitioned caches cannot be specialized.\n";
+        return none;
+    }
+
+    const char* sourceOverride = std::getenv("MHS_SOURCE");
+    char resolved[PATH_MAX];
+    if (!realpath(sourceOverride ? sourceOverride : __FILE__, resolved)) {
+        std::cerr << "Cannot find simulator source " << (sourceOverride ? sourceOverride : __FILE__)
+            << " (set MHS_SOURCE to its path).\n";
+        return none;
+    }
+    std::string sourcePath = resolved;
+
+    std::string key = std::string(__DATE__ " " __TIME__) + ";" + sourcePath + ";" + describeLevel(config.ram)
+        + ";" + describeLevel(config.tlb) + ";" + std::to_string(config.diskAccessTime);
+    for (size_t i = 0; i < config.caches.size(); ++i) {
+        key += ";" + describeLevel(config.caches[i]);
+    }
+    if (config.splitL1) {
+        key += ";split;" + describeLevel(config.l1i) + ";" + describeLevel(config.itlb);
+    }
+    std::string directory = specializedCacheDirectory();
+    if (directory.empty()) {
+        return none;
+    }
+    std::ostringstream name;
+    name << directory << "/specialized_" << std::hex << std::hash<std::string>()(key);
+    std::string cppPath = name.str() + ".cpp";
+    std::string soPath = name.str() + ".so";
+
+    struct stat objectInfo;
+    if (lstat(soPath.c_str(), &objectInfo) != 0) {
+        // Build under names unique to this process, then rename into place,
+        // so a concurrent run never loads a half-written object
+        std::string partial = name.str() + "." + std::to_string(getpid());
+        std::ofstream out((partial + ".cpp").c_str());
+        generateSpecializedSource(out, config, sourcePath);
+        out.close();
+        if (!out) {
+            std::cerr << "Could not write " << partial << ".cpp\n";
+            return none;
+        }
+
+        const char* compiler = std::getenv("CXX");
+        std::string command = std::string(compiler ? compiler : "c++")
+            + " -std=c++11 -O3 -march=native -shared -fPIC -o " + shellQuote(partial + ".so") + " "
+            + shellQuote(partial + ".cpp");
+        std::cout << "Compiling specialized simulator: " << command << "\n";
+        if (std::system(command.c_str()) != 0) {
+            std::cerr << "Compiling the specialized simulator failed.\n";
+            std::remove((partial + ".cpp").c_str());
+            std::remove((partial + ".so").c_str());
+            return none;
+        }
+        if (std::rename((partial + ".cpp").c_str(), cppPath.c_str()) != 0
+            || std::rename((partial + ".so").c_str(), soPath.c_str()) != 0) {
+            std::cerr << "Could not move the specialized simulator into " << directory << ": "
+                << std::strerror(errno) << "\n";
+            std::remove((partial + ".so").c_str());
+            return none;
+        }
+    }
+    if (!privatePath(soPath, false)) {
+        std::cerr << soPath << " is not a regular file owned by this user and closed to writes by others.\n";
+        return none;
+    }
+
+    void* handle = dlopen(soPath.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        std::cerr << "Could not load specialized simulator: " << dlerror() << "\n";
+        return none;
+    }
+    CreateFunction create = reinterpret_cast<CreateFunction>(dlsym(handle, "mhs_create_specialized"));
+    if (!create) {
+        std::cerr << soPath << " does not export mhs_create_specialized\n";
+        return none;
+    }
+    // The object stays loaded for the life of the process
+    return std::unique_ptr<SimulatorInstance>(create(&config));
+}
+
+#ifndef MHS_NO_MAIN
+
+// Function to load the policy plugin the first time a level selects it
+void ensurePolicyPlugin(int policy) {
+    if (policy != PLUGIN || policyPlugin().handle) {
+        return;
+    }
+    std::string path;
+    std::cout << "Enter replacement policy plugin path (shared object): ";
+    std::cin >> path;
+    if (!loadPolicyPlugin(path)) {
+        std::cerr << "Levels using the plugin policy will fall back to FIFO.\n";
+    }
+}
+
+// Function to get one cache level's parameters from user
+void getCacheLevelConfiguration(const std::string& name, LevelConfig& level) {
+    std::cout << "Enter " << name << " cache size: ";
+    std::cin >> level.size;
+    std::cout << "Enter " << name << " block size: ";
+    std::cin >> level.blockSize;
+    std::cout << "Enter " << name << " access time (in ms): ";
+    std::cin >> level.accessTime;
+    std::cout << "Enter " << name << " associativity (1 = direct-mapped, 0 = fully associative): ";
+    std::cin >> level.ways;
+
+    int policy;
+    std::cout << "Select " << name << " replacement policy (0 - FIFO, 1 - LRU, 2 - Random, 3 - Plugin, 4 - SHiP, 5 - Hawkeye): ";
+    std::cin >> policy;
+    while (policy < 0 || policy > 5) {
+        std::cout << "Invalid input. Select replacement policy (0 - FIFO, 1 - LRU, 2 - Random, 3 - Plugin, 4 - SHiP, 5 - Hawkeye): ";
+        std::cin >> policy;
+    }
+    ensurePolicyPlugin(policy);
+    level.policy = static_cast<ReplacementPolicy>(policy);
+}
+
+// Function to get cache and block sizes from user
+void getCacheConfiguration(std::vector<LevelConfig>& caches) {
+    int numLayers;
+    std::cout << "Enter the number of cache layers (1-3): ";
+    std::cin >> numLayers;
+    while (numLayers < 1 || numLayers > 3) {
+        std::cout << "Invalid input. Enter the number of cache layers (1-3): ";
+        std::cin >> numLayers;
+    }
+
+    caches.resize(numLayers);
+
+    for (int i = 0; i < numLayers; ++i) {
+        getCacheLevelConfiguration("L" + std::to_string(i + 1), caches[i]);
+        caches[i].bypassDead = false;
+        if (i > 0) {
+            std::string bypassChoice;
+            std::cout << "Bypass blocks predicted dead at L" << i + 1 << "? (yes/no): ";
+            std::cin >> bypassChoice;
+            caches[i].bypassDead = (bypassChoice == "yes" || bypassChoice == "Yes");
+        }
+    }
+}
+
+// Function to get a TLB's parameters from user
+void getTlbConfiguration(const std::string& name, LevelConfig& tlb) {
+    std::cout << "Enter " << name << " size (Note that TLB's block size is equal to cache level 1's block size): ";
+    std::cin >> tlb.size;
+    tlb.blockSize = 1;
+    std::cout << "Enter " << name << " access time (in ms): ";
+    std::cin >> tlb.accessTime;
+    std::cout << "Enter " << name << " associativity (1 = direct-mapped, 0 = fully associative): ";
+    std::cin >> tlb.ways;
+    int policy;
+    std::cout << "Select " << name << " replacement policy (0 - FIFO, 1 - LRU, 2 - Random, 3 - Plugin, 4 - SHiP, 5 - Hawkeye): ";
+    std::cin >> policy;
+    ensurePolicyPlugin(policy);
+    tlb.policy = static_cast<ReplacementPolicy>(policy);
+}
+
+// Function to get RAM configuration from user
+void getRAMConfiguration(LevelConfig& ram) {
+    std::cout << "Enter RAM size: ";
+    std::cin >> ram.size;
+    std::cout << "Enter RAM block size: ";
+    std::cin >> ram.blockSize;
+    std::cout << "Enter RAM access time (in ms): ";
+    std::cin >> ram.accessTime;
+    std::cout << "Enter RAM associativity (1 = direct-mapped, 0 = fully associative): ";
+    std::cin >> ram.ways;
+    int ramPolicy;
+    std::cout << "Select RAM replacement policy (0 - FIFO, 1 - LRU, 2 - Random, 3 - Plugin, 4 - SHiP, 5 - Hawkeye): ";
+    std::cin >> ramPolicy;
+    while (ramPolicy < 0 || ramPolicy > 5) {
+        std::cout << "Invalid input. Select RAM replacement policy (0 - FIFO, 1 - LRU, 2 - Random, 3 - Plugin, 4 - SHiP, 5 - Hawkeye): ";
+        std::cin >> ramPolicy;
+    }
+    ensurePolicyPlugin(ramPolicy);
+    ram.policy = static_cast<ReplacementPolicy>(ramPolicy);
+}
+
+// Function to get the NUMA layout of the given cores from user
+void getNumaConfiguration(NumaConfig& numa, int numCores) {
+    int numNodes;
+    std::cout << "Enter the number of memory nodes (1 = uniform memory): ";
+    std::cin >> numNodes;
+    numNodes = std::max(1, numNodes);
+    numa.nodes.assign(numNodes, MemoryNodeConfig());
+    numa.homeNodes.assign(numCores, 0);
+    numa.placement = FIRST_TOUCH;
+    numa.bindNode = 0;
+    if (numNodes == 1) {
+        return;
+    }
+
+    for (int i = 0; i < numNodes; ++i) {
+        std::cout << "Enter node " << i << " local access time (in ms): ";
+        std::cin >> numa.nodes[i].localAccessTime;
+        std::cout << "Enter node " << i << " remote access time (in ms): ";
+        std::cin >> numa.nodes[i].remoteAccessTime;
+        std::cout << "Enter node " << i << " local bandwidth (bytes per ms, 0 = unlimited): ";
+        std::cin >> numa.nodes[i].localBandwidth;
+        std::cout << "Enter node " << i << " remote bandwidth (bytes per ms, 0 = unlimited): ";
+        std::cin >> numa.nodes[i].remoteBandwidth;
+    }
+
+    for (size_t i = 0; i < numa.homeNodes.size(); ++i) {
+        std::cout << "Enter home node of core " << i << " (0-" << numNodes - 1 << "): ";
+        std::cin >> numa.homeNodes[i];
+        numa.homeNodes[i] = std::min(std::max(0, numa.homeNodes[i]), numNodes - 1);
+    }
+
+    int placement;
+    std::cout << "Select page placement policy (0 - First-touch, 1 - Interleave, 2 - Bind): ";
+    std::cin >> placement;
+    while (placement < 0 || placement > 2) {
+        std::cout << "Invalid input. Select page placement policy (0 - First-touch, 1 - Interleave, 2 - Bind): ";
+        std::cin >> placement;
+    }
+    numa.placement = static_cast<PagePlacement>(placement);
+    if (numa.placement == BIND) {
+        std::cout << "Enter node to bind pages to (0-" << numNodes - 1 << "): ";
+        std::cin >> numa.bindNode;
+        numa.bindNode = std::min(std::max(0, numa.bindNode), numNodes - 1);
+    }
+}
+
+// Function to get memory tiers from user (used with uniform memory only)
+void getTieringConfiguration(TieringConfig& tiering) {
+    int numTiers;
+    std::cout << "Enter the number of memory tiers (1 = single tier): ";
+    std::cin >> numTiers;
+    numTiers = std::max(1, numTiers);
+    tiering.tiers.assign(numTiers, TierConfig());
+    tiering.epochLength = 1;
+    tiering.hotThreshold = 1;
+    tiering.maxMigrations = 0;
+    if (numTiers == 1) {
+        return;
+    }
+
+    for (int i = 0; i < numTiers; ++i) {
+        std::cout << "Enter tier " << i + 1 << " name (fastest first, e.g. HBM, DRAM, NVM, CXL): ";
+        std::cin >> tiering.tiers[i].name;
+        if (i < numTiers - 1) {
+            std::cout << "Enter " << tiering.tiers[i].name << " capacity (in RAM pages): ";
+            std::cin >> tiering.tiers[i].capacityPages;
+            while (tiering.tiers[i].capacityPages <= 0) {
+                std::cout << "Invalid input. Enter " << tiering.tiers[i].name << " capacity (in RAM pages, at least 1): ";
+                std::cin >> tiering.tiers[i].capacityPages;
+            }
+        }
+        std::cout << "Enter " << tiering.tiers[i].name << " access time (in ms): ";
+        std::cin >> tiering.tiers[i].accessTime;
+        std::cout << "Enter " << tiering.tiers[i].name << " bandwidth (bytes per ms, 0 = unlimited): ";
+        std::cin >> tiering.tiers[i].bandwidth;
+    }
+    std::cout << "Enter migration epoch length (memory accesses between migration passes): ";
+    std::cin >> tiering.epochLength;
+    std::cout << "Enter hotness threshold (accesses per epoch to promote a page): ";
+    std::cin >> tiering.hotThreshold;
+    std::cout << "Enter maximum promotions per epoch: ";
+    std::cin >> tiering.maxMigrations;
+    tiering.epochLength = std::max(1, tiering.epochLength);
+    tiering.hotThreshold = std::max(1, tiering.hotThreshold);
+}
+
+// Function to get the CXL memory tier from user
+void getCxlConfiguration(CxlConfig& cxl) {
+    std::string choice;
+    std::cout << "Add a CXL-attached memory tier below RAM? (yes/no): ";
+    std::cin >> choice;
+    cxl = CxlConfig();
+    cxl.enabled = (choice == "yes" || choice == "Yes");
+    if (!cxl.enabled) {
+        return;
+    }
+
+    std::cout << "Enter CXL memory size: ";
+    std::cin >> cxl.size;
+    std::cout << "Enter CXL media access time (in ms): ";
+    std::cin >> cxl.mediaAccessTime;
+    int policy;
+    std::cout << "Select CXL page replacement policy (0 - FIFO, 1 - LRU, 2 - Random, 3 - Plugin, 4 - SHiP, 5 - Hawkeye): ";
+    std::cin >> policy;
+    while (policy < 0 || policy > 5) {
+        std::cout << "Invalid input. Select CXL page replacement policy (0 - FIFO, 1 - LRU, 2 - Random, 3 - Plugin, 4 - SHiP, 5 - Hawkeye): ";
+        std::cin >> policy;
+    }
+    ensurePolicyPlugin(policy);
+    cxl.policy = static_cast<ReplacementPolicy>(policy);
+    std::cout << "Enter CXL link latency, one way (in ms): ";
+    std::cin >> cxl.linkLatency;
+    std::cout << "Enter CXL link bandwidth (bytes per ms, 0 = unlimited): ";
+    std::cin >> cxl.linkBandwidth;
+    std::cout << "Enter CXL flit size and data bytes per flit (e.g. 68 64): ";
+    std::cin >> cxl.flitSize >> cxl.flitPayload;
+    std::cout << "Enter CXL device cache size (0 = none): ";
+    std::cin >> cxl.deviceCacheSize;
+    if (cxl.deviceCacheSize > 0) {
+        std::cout << "Enter CXL device cache access time (in ms): ";
+        std::cin >> cxl.deviceCacheAccessTime;
+    }
+}
+
+// Function to get the remote memory parameters from user
+void getRemoteMemoryConfiguration(RemoteMemoryConfig& remote) {
+    std::cout << "Enter remote page fetch base latency (in ms): ";
+    std::cin >> remote.baseLatency;
+    std::cout << "Enter mean of exponential fetch jitter (in ms, 0 = none): ";
+    std::cin >> remote.jitterMean;
+    std::cout << "Enter tail probability and extra tail latency in ms (e.g. 0.01 50): ";
+    std::cin >> remote.tailProbability >> remote.tailLatency;
+    std::cout << "Enter neighbouring pages to prefetch per fetch: ";
+    std::cin >> remote.prefetchPages;
+    std::cout << "Enter local page cache size (in pages, 0 = none): ";
+    std::cin >> remote.localCachePages;
+    if (remote.localCachePages > 0) {
+        std::cout << "Enter local page cache access time (in ms): ";
+        std::cin >> remote.localCacheAccessTime;
+    }
+}
+
+// Function to get the backing store below main memory from user
+void getBackingStoreConfiguration(BackingStoreConfig& backing) {
+    backing = BackingStoreConfig();
+    int type;
+    std::cout << "Select backing store (0 - Constant-time disk, 1 - Remote memory, 2 - HDD, 3 - SSD): ";
+    std::cin >> type;
+    while (type < 0 || type > 3) {
+        std::cout << "Invalid input. Select backing store (0 - Constant-time disk, 1 - Remote memory, 2 - HDD, 3 - SSD): ";
+        std::cin >> type;
+    }
+    backing.type = static_cast<BackingStoreType>(type);
+    if (backing.type == HDD) {
+        HddConfig& hdd = backing.hdd;
+        std::cout << "Enter HDD rotational speed (RPM): ";
+        std::cin >> hdd.rpm;
+        std::cout << "Enter HDD track-to-track and full-stroke seek times (in ms, e.g. 0.5 12): ";
+        std::cin >> hdd.minSeekTime >> hdd.maxSeekTime;
+        std::cout << "Enter HDD transfer rate (bytes per ms): ";
+        std::cin >> hdd.transferRate;
+    }
+    if (backing.type == SSD) {
+        SsdConfig& ssd = backing.ssd;
+        std::cout << "Enter SSD channels and dies per channel (e.g. 8 4): ";
+        std::cin >> ssd.channels >> ssd.diesPerChannel;
+        std::cout << "Enter SSD queue depth: ";
+        std::cin >> ssd.queueDepth;
+        std::cout << "Enter SSD page read and write times (in ms, e.g. 0.05 0.5): ";
+        std::cin >> ssd.readTime >> ssd.writeTime;
+        std::cout << "Enter SSD channel bandwidth (bytes per ms, 0 = unlimited): ";
+        std::cin >> ssd.channelBandwidth;
+        std::cout << "Enter page writes between garbage-collection stalls (0 = none) and stall time in ms: ";
+        std::cin >> ssd.gcInterval >> ssd.gcStallTime;
+    }
+    if (backing.type == REMOTE_MEMORY) {
+        getRemoteMemoryConfiguration(backing.remote);
+    }
+
+    std::string choice;
+    std::cout << "Add an OS page cache with readahead in front of it? (yes/no): ";
+    std::cin >> choice;
+    PageCacheConfig& pageCache = backing.pageCache;
+    pageCache.enabled = (choice == "yes" || choice == "Yes");
+    if (!pageCache.enabled) {
+        return;
+    }
+    std::cout << "Enter page cache size (in pages): ";
+    std::cin >> pageCache.capacityPages;
+    std::cout << "Enter page cache access time (in ms): ";
+    std::cin >> pageCache.accessTime;
+    std::cout << "Enter initial and maximum readahead window (in pages, e.g. 4 32): ";
+    std::cin >> pageCache.initialWindow >> pageCache.maxWindow;
+    std::cout << "Enter background and throttling dirty thresholds (percent of cache, e.g. 10 20): ";
+    std::cin >> pageCache.backgroundDirtyPercent >> pageCache.dirtyPercent;
+}
+
+// Function to get the per-core store buffer configuration from user
+void getStoreBufferConfiguration(StoreBufferConfig& storeBuffer) {
+    storeBuffer = StoreBufferConfig();
+    std::cout << "Enter store buffer depth per core (0 = stores block like loads): ";
+    std::cin >> storeBuffer.depth;
+    if (storeBuffer.depth <= 0) {
+        storeBuffer.depth = 0;
+        return;
+    }
+    std::cout << "Enter store buffer access time (in ms): ";
+    std::cin >> storeBuffer.accessTime;
+    std::cout << "Enter write-combining buffers per core (0 = none): ";
+    std::cin >> storeBuffer.combiningBuffers;
+    int policy;
+    std::cout << "Select drain policy (0 - Eager, 1 - Lazy, wait until half full): ";
+    std::cin >> policy;
+    while (policy < 0 || policy > 1) {
+        std::cout << "Invalid input. Select drain policy (0 - Eager, 1 - Lazy, wait until half full): ";
+        std::cin >> policy;
+    }
+    storeBuffer.drainPolicy = static_cast<DrainPolicy>(policy);
+}
+
+// Function to get the cache partitioning between tenants from user
+void getPartitionConfiguration(PartitionConfig& partition, int numCaches) {
+    partition = PartitionConfig();
+    std::cout << "Partition a cache level between tenants? (0 = no, or the level number): ";
+    std::cin >> partition.level;
+    if (partition.level <= 0 || partition.level > numCaches) {
+        partition.level = 0;
+        return;
+    }
+    std::cout << "Enter the number of tenants (tenant = core % tenants): ";
+    std::cin >> partition.tenants;
+    partition.tenants = std::max(1, partition.tenants);
+    int mode;
+    std::cout << "Select partitioning (0 - Static way masks, 1 - Utility-based): ";
+    std::cin >> mode;
+    while (mode < 0 || mode > 1) {
+        std::cout << "Invalid input. Select partitioning (0 - Static way masks, 1 - Utility-based): ";
+        std::cin >> mode;
+    }
+    partition.mode = static_cast<PartitionMode>(mode);
+    if (partition.mode == UTILITY_BASED) {
+        std::cout << "Enter repartitioning epoch (in accesses to the level): ";
+        std::cin >> partition.epochLength;
+        return;
+    }
+    partition.masks.resize(partition.tenants);
+    for (int t = 0; t < partition.tenants; ++t) {
+        std::string mask;
+        std::cout << "Enter way mask of tenant " << t << " (hex, e.g. 0xf0): ";
+        std::cin >> mask;
+        partition.masks[t] = std::strtoull(mask.c_str(), nullptr, 16);
+    }
+}
+
+// Function to get the auto-tuner's search budget from user
+void getTunerConfiguration(TunerConfig& tuner, int numCaches) {
+    std::cout << "Enter the number of configurations to sample: ";
+    std::cin >> tuner.candidates;
+    tuner.costPerKB.resize(numCaches);
+    for (int i = 0; i < numCaches; ++i) {
+        std::cout << "Enter L" << i + 1 << " cost per KB (area, energy or price units): ";
+        std::cin >> tuner.costPerKB[i];
+    }
+    std::cout << "Enter cost budget (0 = unlimited): ";
+    std::cin >> tuner.budget;
+    std::cout << "Enter tuner threads (0 = one per hardware thread): ";
+    std::cin >> tuner.threads;
+    std::cout << "Enter tuner seed (0 = from the clock): ";
+    std::cin >> tuner.seed;
+}
+
+// Function to get the address range and random-pattern parameters from user
+void getWorkloadConfiguration(WorkloadConfig& workload) {
+    std::cout << "Enter start address: ";
+    std::cin >> workload.startAddress;
+    while (workload.startAddress < 0) {
+        std::cout << "Invalid input. Enter start address (0 or more): ";
+        std::cin >> workload.startAddress;
+    }
+    std::cout << "Enter end address: ";
+    std::cin >> workload.endAddress;
+    workload.count = 0;
+    workload.skew = 0;
+    workload.seed = 0;
+    if (workload.pattern != 2 && workload.pattern != 5) {
+        return;
+    }
+    std::cout << "Enter number of accesses: ";
+    std::cin >> workload.count;
+    if (workload.pattern == 5) {
+        std::cout << "Enter zipfian skew (between 0 and 1, e.g. 0.99): ";
+        std::cin >> workload.skew;
+        while (!(workload.skew > 0 && workload.skew < 1)) {
+            std::cout << "Invalid input. Enter zipfian skew (between 0 and 1, e.g. 0.99): ";
+            std::cin >> workload.skew;
+        }
+    }
+    std::cout << "Enter random seed (0 = from the clock): ";
+    std::cin >> workload.seed;
+}
+
+// Function to get a level's latency distribution from user
+void getLatencyConfiguration(const std::string& name, LatencyConfig& latency) {
+    latency = LatencyConfig();
+    int shape;
+    std::cout << "Select " << name << " latency distribution (0 - Fixed, 1 - Uniform, 2 - Lognormal, 3 - Empirical"
+        " histogram file): ";
+    std::cin >> shape;
+    while (shape < 0 || shape > 3) {
+        std::cout << "Invalid input. Select " << name << " latency distribution (0 - Fixed, 1 - Uniform, 2 - "
+            "Lognormal, 3 - Empirical histogram file): ";
+        std::cin >> shape;
+    }
+    latency.shape = static_cast<LatencyShape>(shape);
+    if (latency.shape == UNIFORM_LATENCY) {
+        std::cout << "Enter " << name << " latency spread (in ms, access time +/- spread): ";
+        std::cin >> latency.spread;
+    }
+    else if (latency.shape == LOGNORMAL_LATENCY) {
+        std::cout << "Enter " << name << " latency sigma (log-space; the access time is the median): ";
+        std::cin >> latency.sigma;
+    }
+    else if (latency.shape == EMPIRICAL_LATENCY) {
+        std::string path;
+        std::cout << "Enter " << name << " latency histogram file (lines of \"<latency in ms> <count>\"): ";
+        std::cin >> path;
+        std::ifstream in(path.c_str());
+        double value, weight;
+        while (in >> value >> weight) {
+            if (weight > 0) {
+                latency.values.push_back(value);
+                latency.weights.push_back(weight);
+            }
+        }
+        if (latency.values.empty()) {
+            std::cerr << "No latencies read from " << path << ", using the fixed access time.\n";
+            latency.shape = FIXED_LATENCY;
+        }
+    }
+}
+
+// Function to get the follow-mode window and polling parameters from user
+void getFollowConfiguration(FollowConfig& follow) {
+    std::cout << "Enter statistics window length (in accesses): ";
+    std::cin >> follow.windowLength;
+    follow.windowLength = std::max(1LL, follow.windowLength);
+    std::cout << "Enter poll interval for new records (in ms): ";
+    std::cin >> follow.pollInterval;
+    std::cout << "Stop after how many seconds without new records? (0 = never): ";
+    std::cin >> follow.idleTimeout;
+}
+
+// Function to get the phase sampling parameters from user
+void getPhaseConfiguration(PhaseConfig& phases) {
+    std::cout << "Enter interval length (in accesses): ";
+    std::cin >> phases.intervalLength;
+    std::cout << "Enter maximum number of phases: ";
+    std::cin >> phases.maxClusters;
+    std::cout << "Enter clustering threads (0 = one per hardware thread): ";
+    std::cin >> phases.threads;
+    std::string compareChoice;
+    std::cout << "Also simulate the whole trace to measure the error? (yes/no): ";
+    std::cin >> compareChoice;
+    phases.compare = (compareChoice == "yes" || compareChoice == "Yes");
+}
+
+// Main function
+int main() {
+    HierarchyConfig config;
+    WorkloadConfig workload;
+    std::string tracePath;
+
+    // Loop to allow user to configure cache multiple times
+    while (true) {
+        // Get cache configuration from user
+        getCacheConfiguration(config.caches);
+        std::string splitChoice;
+        std::cout << "Use separate L1 instruction and data caches (L1 above becomes L1D)? (yes/no): ";
+        std::cin >> splitChoice;
+        config.splitL1 = (splitChoice == "yes" || splitChoice == "Yes");
+        if (config.splitL1) {
+            getCacheLevelConfiguration("L1I", config.l1i);
+        }
+
+        // Get RAM configuration from user
+        getRAMConfiguration(config.ram);
+
+        std::cout << "Enter the number of cores: ";
+        std::cin >> config.cores;
+        while (config.cores < 1) {
+            std::cout << "Invalid input. Enter the number of cores: ";
+            std::cin >> config.cores;
+        }
+        getNumaConfiguration(config.numa, config.cores);
+        config.tiering = TieringConfig();
+        if (config.numa.nodes.size() == 1) {
+            getTieringConfiguration(config.tiering);
+        }
+        getCxlConfiguration(config.cxl);
+        config.ramLatency = LatencyConfig();
+        if (config.numa.nodes.size() < 2 && config.tiering.tiers.size() < 2) {
+            getLatencyConfiguration("RAM", config.ramLatency);
+        }
+
+        std::cout << "Enter Disk size: ";
+        std::cin >> config.diskSize;
+        std::cout << "Enter Disk access time (in ms): ";
+        std::cin >> config.diskAccessTime;
+        getBackingStoreConfiguration(config.backing);
+        config.diskLatency = LatencyConfig();
+        if (config.backing.type == LOCAL_DISK) {
+            getLatencyConfiguration("Disk", config.diskLatency);
+        }
+
+        getTlbConfiguration(config.splitL1 ? "dTLB" : "TLB", config.tlb);
+        if (config.splitL1) {
+            getTlbConfiguration("iTLB", config.itlb);
+        }
+
+        std::cout << "Enable Bloom-filter fast-miss path for levels of " << MISS_FILTER_MIN_BLOCKS
+            << "+ blocks? (yes/no): ";
+        std::string filterChoice;
+        std::cin >> filterChoice;
+        config.filterMisses = (filterChoice == "yes" || filterChoice == "Yes");
+        getStoreBufferConfiguration(config.storeBuffer);
+        getPartitionConfiguration(config.partition, static_cast<int>(config.caches.size()));
+        std::cout << "Enter working-set window length in accesses (0 = off): ";
+        std::cin >> config.workingSetWindow;
+
+        std::string serveChoice;
+        std::cout << "Serve this configuration on a Unix domain socket instead of running a workload? (yes/no): ";
+        std::cin >> serveChoice;
+        if (serveChoice == "yes" || serveChoice == "Yes") {
+            std::string socketPath;
+            std::cout << "Enter socket path: ";
+            std::cin >> socketPath;
+            SimulationServer server(config);
+            server.serve(socketPath);
+        }
+        else {
+            // Select memory access pattern
+            std::cout << "\nSelect memory access pattern:\n";
+            std::cout << "1. Sequential Access\n";
+            std::cout << "2. Random Access\n";
+            std::cout << "3. Loop Access\n";
+            std::cout << "4. Trace File (Valgrind lackey format)\n";
+            std::cout << "5. Zipfian Access\n";
+            std::cout << "Enter your choice (1-5): ";
+            std::cin >> workload.pattern;
+
+            std::string followChoice;
+            if (workload.pattern == 4) {
+                std::cout << "Enter trace file path: ";
+                std::cin >> tracePath;
+                std::cout << "Follow the trace file as it grows (live monitoring)? (yes/no): ";
+                std::cin >> followChoice;
+            }
+            else {
+                getWorkloadConfiguration(workload);
+            }
+            bool follow = (followChoice == "yes" || followChoice == "Yes");
+
+            int numCores = config.cores;
+            std::string tuneChoice;
+            if (!follow) {
+                std::cout << "Auto-tune the caches around this configuration instead of running it? (yes/no): ";
+                std::cin >> tuneChoice;
+            }
+            std::string estimateChoice;
+            if (!follow && tuneChoice != "yes" && tuneChoice != "Yes") {
+                std::cout << "Estimate miss ratios from sampled reuse distances (StatStack/StatCache)? (yes/no): ";
+                std::cin >> estimateChoice;
+            }
+            std::string phaseChoice;
+            if (!follow && tuneChoice != "yes" && tuneChoice != "Yes" && estimateChoice != "yes" && estimateChoice != "Yes") {
+                std::cout << "Simulate only representative intervals of each program phase (SimPoint)? (yes/no): ";
+                std::cin >> phaseChoice;
+            }
+            int replicas = 1;
+            if (!follow && tuneChoice != "yes" && tuneChoice != "Yes" && estimateChoice != "yes" && estimateChoice != "Yes"
+                && phaseChoice != "yes" && phaseChoice != "Yes") {
+                std::cout << "Enter number of independently seeded replicas (1 = single run): ";
+                std::cin >> replicas;
+            }
+            if (follow) {
+                FollowConfig followConfig;
+                getFollowConfiguration(followConfig);
+                followTrace(config, tracePath, numCores, followConfig);
+            }
+            else if (tuneChoice == "yes" || tuneChoice == "Yes") {
+                TunerConfig tuner;
+                getTunerConfiguration(tuner, static_cast<int>(config.caches.size()));
+                std::vector<MemoryAccess> accesses = workload.pattern == 4 ? loadTrace(tracePath, numCores)
+                    : generateAccesses(workload, numCores);
+                reportParetoFront(autoTune(config, accesses, tuner));
+            }
+            else if (estimateChoice == "yes" || estimateChoice == "Yes") {
+                int samplePeriod;
+                std::cout << "Enter sampling period (sample one access in N): ";
+                std::cin >> samplePeriod;
+                std::string validateChoice;
+                std::cout << "Also simulate the whole trace to measure the error? (yes/no): ";
+                std::cin >> validateChoice;
+                std::vector<MemoryAccess> accesses = workload.pattern == 4 ? loadTrace(tracePath, numCores)
+                    : generateAccesses(workload, numCores);
+                estimateMissRatios(config, accesses, samplePeriod, validateChoice == "yes" || validateChoice == "Yes");
+            }
+            else if (phaseChoice == "yes" || phaseChoice == "Yes") {
+                PhaseConfig phases;
+                getPhaseConfiguration(phases);
+                std::vector<MemoryAccess> accesses = workload.pattern == 4 ? loadTrace(tracePath, numCores)
+                    : generateAccesses(workload, numCores);
+                simulatePhases(config, accesses, phases);
+            }
+            else if (replicas > 1) {
+                unsigned long long replicaSeed;
+                std::cout << "Enter replica seed (0 = from the clock): ";
+                std::cin >> replicaSeed;
+                std::vector<MemoryAccess> accesses = workload.pattern == 4 ? loadTrace(tracePath, numCores)
+                    : generateAccesses(workload, numCores);
+                runReplicas(config, accesses, replicas, replicaSeed);
+            }
+            else {
+                std::string specializeChoice;
+                std::cout << "Compile a specialized simulator for this configuration? (yes/no): ";
+                std::cin >> specializeChoice;
+                std::string verboseChoice;
+                std::cout << "Show every access? (yes/no): ";
+                std::cin >> verboseChoice;
+
+                // Create the simulator and run it
+                std::unique_ptr<SimulatorInstance> simulator;
+                if (specializeChoice == "yes" || specializeChoice == "Yes") {
+                    simulator = loadSpecializedSimulator(config);
+                    if (!simulator) {
+                        std::cerr << "Using the interpreted simulator instead.\n";
+                    }
+                }
+                if (!simulator) {
+                    simulator.reset(new MemoryHierarchy(config));
+                }
+                simulator->setVerbose(verboseChoice == "yes" || verboseChoice == "Yes");
+                if (workload.pattern == 4) {
+                    simulator->runTrace(tracePath, numCores);
+                }
+                else {
+                    simulator->runSimulation(workload, numCores);
+                }
+            }
+        }
+
+        // Option to continue or exit
+        std::string choice;
+        std::cout << "\nDo you want to configure another cache? (yes/no): ";
+        std::cin >> choice;
+        if (choice != "yes" && choice != "Yes") {
+            break; // Exit the loop if user does not want to continue
         }
     }
     return 0;
 }
+
+#endif  // MHS_NO_MAIN